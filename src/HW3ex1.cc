@@ -9,6 +9,12 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <deque>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
 #include <cstring>   // for strcmp
 #include "hcm.h"
 #include "flat.h"
@@ -17,6 +23,21 @@
 #include "utils/Options.h"
 #include "core/Dimacs.h"
 #include "core/Solver.h"
+#include "aig.h"
+#include "fraig.h"
+#include "netlist.h"
+#include "sim.h"
+#include "sched.h"
+#include "simplify.h"
+#include "cnfout.h"
+#include "stats.h"
+#include "budget.h"
+#include "batch.h"
+#include "vlgread.h"
+#include "keypoint.h"
+#include "seq.h"
+#include "proofcache.h"
+#include "bdd.h"
 
 using namespace std;
 using namespace Minisat;
@@ -24,6 +45,51 @@ using namespace Minisat;
 // globals
 bool verbose = false;
 
+// Conflict limit of each SAT call of the sweeping engine (-f).
+const int64_t FRAIG_CONF_LIMIT = 1000;
+
+// Conflict limit of each key-point proof (-k).
+const int64_t KEYPOINT_CONF_LIMIT = 1000;
+
+// Cone cost (gates or AIG nodes) from which an output gets a parallel
+// job of its own; cheaper outputs are batched up to this cost (-j).
+const size_t JOB_BATCH_COST = 4096;
+
+// Conflicts of the warm-up query that ranks the split variables of
+// cube and conquer (--cubes).
+const int64_t CUBE_WARMUP_CONFLICTS = 2000;
+// Largest --cubes depth (2^16 cubes).
+const int MAX_CUBE_DEPTH = 16;
+
+// Conflict limit of each query that tries to drop an input from a
+// counterexample (--cex); an undecided query keeps the input.
+const int64_t CEX_MINIMIZE_CONF_LIMIT = 1000;
+
+// Node limit of the BDDs of one output (--bdd); larger cones go to SAT.
+const size_t BDD_MAX_NODES = 1 << 20;
+
+// Budget of every solver query (--budget). Queries that run out are
+// retried up to budgetRetries times, each time with the budget
+// multiplied by BUDGET_ESCALATION.
+Budget queryBudget;
+int budgetRetries = 0;
+const double BUDGET_ESCALATION = 4;
+
+// Bounded variable elimination on every miter solver before its first
+// query (-e).
+bool preprocessCnf = false;
+
+// Verdict of a single PO pair in the per-output mode.
+enum OutputStatus { OUT_UNKNOWN, OUT_PROVEN, OUT_FAILED };
+
+const char* outputStatusName(OutputStatus st) {
+    switch (st) {
+    case OUT_PROVEN: return "PROVEN";
+    case OUT_FAILED: return "FAILED";
+    default:         return "UNKNOWN";
+    }
+}
+
 // Extract primary ports from a top-level cell (PIs and POs)
 void extractPorts(hcmCell* cell, vector<string>& inputs, vector<string>& outputs) {
     for (auto port : cell->getPorts()) {
@@ -34,139 +100,635 @@ void extractPorts(hcmCell* cell, vector<string>& inputs, vector<string>& outputs
     }
 }
 
-// Extract instportports from an instance
-void extractPorts(hcmInstance* instance, vector<string>& inputs, vector<string>& outputs) {
-    for (auto instport : instance->getInstPorts()) {
-        if (instport.second->getPort()->getDirection() == IN)
-            inputs.push_back(instport.second->getNode()->getName());
-        else if (instport.second->getPort()->getDirection() == OUT)
-            outputs.push_back(instport.second->getNode()->getName());
+//--------------------------------------------------------------------
+// The engines below work on the flat netlists of netlist.h: nets and
+// gates are dense ids, and names are only used to match the ports of
+// the two designs and to report results.
+
+// Ports of a flat netlist, matched by name to the sorted port lists of
+// the miter: piIndex maps a net id to the position of that net among the
+// primary inputs (-1 for other nets), outNets[o] is the net of output o.
+// Cut points (-k) are sources like the inputs, numbered after them; the
+// fan-in of a cut net is never encoded.
+struct MiterPorts {
+    vector<int> piIndex;
+    vector<int> outNets;
+    vector<int> cutNets;
+
+    MiterPorts(const Netlist& nl, const vector<string>& inputs, const vector<string>& outputs)
+        : piIndex(nl.numNets(), -1) {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            int net = nl.findNet(inputs[i]);
+            if (net >= 0)
+                piIndex[net] = i;
+        }
+        for (const auto& out : outputs)
+            outNets.push_back(nl.findNet(out));
+    }
+
+    void addCut(int net, int index) {
+        piIndex[net] = index;
+        cutNets.push_back(net);
     }
+};
+
+//--------------------------------------------------------------------
+// This function generates the CNF clauses of gate g of the netlist with
+// the emitter of its cell. netVars must hold the variables of the gate's
+// fanins and output. 'pins' and 'clause' are scratch space, passed in so
+// that the encoding loop does not allocate.
+void encodeGate(const Netlist& nl, int g, CnfSolver& solver, const vector<Var>& netVars,
+                vec<Lit>& pins, vec<Lit>& clause) {
+    const CellDef& cell = nl.lib.cell(nl.gateCells[g]);
+    pins.clear();
+    for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+        pins.push(mkLit(netVars[nl.fanins[k]]));
+    pins.push(mkLit(netVars[nl.gateOuts[g]]));
+    cell.emit(cell, solver, &pins[0], clause);
 }
 
-// A helper function to obtain the variable for a given signal name.
-// If the signal is "VDD" or "VSS", we create a variable and then add
-// a unit clause forcing it to 1 or 0 respectively.
-Var getOrCreateVar(const string& sig,
-                   Solver& solver,
-                   map<string, Var>& varMap) {
-    // If already present, return it.
-    if (varMap.find(sig) != varMap.end())
-        return varMap[sig];
+// Encoding state of one flat netlist in one solver: the gates already
+// turned into clauses and the net -> variable table. The netlist and its
+// ports are read-only and shared by all solvers.
+struct CnfNetlist {
+    const Netlist& nl;
+    const MiterPorts& ports;
+    vector<Var> netVars;        // net id -> variable, var_Undef until used
+    vector<char> encoded;       // gate -> already in the solver
+    size_t numEncoded = 0;
+    vector<int> cone, roots;    // scratch space of encodeCone
+    vec<Lit> pins, clause;
 
-    // For constant nets, create the variable and force its value.
-    if (sig == "VDD") {
-        Var v = solver.newVar();
-        varMap[sig] = v;
-        // Force v to be true: add clause (v)
-        solver.addClause(mkLit(v));
-        return v;
+    CnfNetlist(const Netlist& nl, const MiterPorts& ports)
+        : nl(nl), ports(ports), netVars(nl.numNets(), var_Undef), encoded(nl.numGates(), 0) {
+        // Cone collection stops at the drivers of the cut points.
+        for (int net : ports.cutNets)
+            if (nl.driver[net] >= 0)
+                encoded[nl.driver[net]] = 1;
     }
-    if (sig == "VSS") {
-        Var v = solver.newVar();
-        varMap[sig] = v;
-        // Force v to be false: add clause (~v)
-        solver.addClause(~mkLit(v));
+};
+
+// Variable of a net, created on first use. Primary inputs and cut
+// points are shared with the other design through inputVars. VDD/VSS
+// get a unit clause forcing them to 1/0.
+Var netVar(CnfNetlist& cnf, int net, CnfSolver& solver, vector<Var>& inputVars) {
+    Var& v = cnf.netVars[net];
+    if (v != var_Undef)
         return v;
+    int pi = cnf.ports.piIndex[net];
+    if (pi >= 0) {
+        if (inputVars[pi] == var_Undef)
+            inputVars[pi] = solver.newVar();
+        return v = inputVars[pi];
     }
-    // Otherwise, create a new variable.
-    Var v = solver.newVar();
-    varMap[sig] = v;
+    v = solver.newVar();
+    if (net == cnf.nl.vdd)
+        solver.addClause(mkLit(v));
+    else if (net == cnf.nl.vss)
+        solver.addClause(~mkLit(v));
     return v;
 }
 
+// Encode the part of the cones of outputs 'outs' that is not in the
+// solver yet. Outputs without a driver become free variables. Returns
+// the number of gates added.
+size_t encodeCone(CnfNetlist& cnf, const vector<size_t>& outs, CnfSolver& solver, vector<Var>& inputVars) {
+    const Netlist& nl = cnf.nl;
+    cnf.roots.clear();
+    for (size_t o : outs)
+        cnf.roots.push_back(cnf.ports.outNets[o]);
+    cnf.cone.clear();
+    collectCone(nl, cnf.roots, cnf.encoded, cnf.cone);
+    for (int g : cnf.cone) {
+        for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+            netVar(cnf, nl.fanins[k], solver, inputVars);
+        netVar(cnf, nl.gateOuts[g], solver, inputVars);
+        encodeGate(nl, g, solver, cnf.netVars, cnf.pins, cnf.clause);
+    }
+    for (int root : cnf.roots)
+        netVar(cnf, root, solver, inputVars);
+    cnf.numEncoded += cnf.cone.size();
+    return cnf.cone.size();
+}
+
 //--------------------------------------------------------------------
-// This function generates CNF clauses for the circuit in 'cell'.
-// Primary inputs (if their names are in the set primaryInputs) 
-// are shared using the globalInputMap.
-// Function to generate CNF from circuit logic
-void generateCNF(hcmCell* cell, Solver& solver, map<string, Var>& varMap,
-                 const set<string>& primaryInputs, map<string, Var>& globalInputMap) {
-    for (auto gate : cell->getInstances()) {
-        vec<Lit> clause;
-        clause.clear();
-        string gateType = gate.second->masterCell()->getName();
-        vector<string> inputs, outputs;
-        extractPorts(gate.second, inputs, outputs);
-        if (inputs.empty() || outputs.empty())
-            continue;
+// Provides the solver literals of the spec and impl outputs for the
+// miter. encode() brings the cones of the given outputs into the solver
+// and sets their entries in specLits/impLits.
+class MiterEncoder {
+public:
+    virtual ~MiterEncoder() {}
+    virtual void encode(CnfSolver& solver, const vector<size_t>& outputs) = 0;
+    // Solver variable of primary input i (in sorted port order),
+    // var_Undef if it is outside every encoded cone.
+    virtual Var inputVar(size_t i) const = 0;
+    // A new encoder over the same designs, for another solver.
+    virtual MiterEncoder* spawn() const = 0;
+    // Size of the spec + impl cones of an output (cost estimate).
+    virtual size_t coneSize(size_t output) const = 0;
+    // Number of gates or nodes encoded so far.
+    virtual size_t numEncoded() const = 0;
+    // Freeze the variables shared by both designs (primary inputs and
+    // cut points), so variable elimination keeps them.
+    virtual void freezeInputs(CnfSolver& solver) const = 0;
+    // Write "<DIMACS literal> <name>" for every encoded signal that has
+    // a name: the primary inputs by their port names, the rest prefixed
+    // with spec: or impl:.
+    virtual void writeSymbols(ostream& out, const vector<string>& inputs,
+                              const vector<string>& outputs) const = 0;
 
-        // Create variables for inputs and outputs.
-        for (const auto& input : inputs){
-            if (primaryInputs.count(input)) {
-                if (globalInputMap.find(input) == globalInputMap.end())
-                    globalInputMap[input] = getOrCreateVar(input, solver, varMap);
-                varMap[input] = globalInputMap[input];
-            } else {
-                getOrCreateVar(input, solver, varMap);
-            }
+    vector<Lit> specLits, impLits;
+};
+
+// Miter over the gate-level CNF of the two flat netlists.
+class NetlistMiterEncoder : public MiterEncoder {
+public:
+    NetlistMiterEncoder(const Netlist& specNl, const MiterPorts& specPorts,
+                        const Netlist& impNl, const MiterPorts& impPorts,
+                        size_t numInputs, size_t numOutputs)
+        : inputVars(numInputs, var_Undef), spec(specNl, specPorts), imp(impNl, impPorts) {
+        specLits.assign(numOutputs, lit_Undef);
+        impLits.assign(numOutputs, lit_Undef);
+    }
+
+    void encode(CnfSolver& solver, const vector<size_t>& outs) {
+        encodeCone(spec, outs, solver, inputVars);
+        encodeCone(imp, outs, solver, inputVars);
+        for (size_t o : outs) {
+            specLits[o] = mkLit(spec.netVars[spec.ports.outNets[o]]);
+            impLits[o] = mkLit(imp.netVars[imp.ports.outNets[o]]);
         }
-        for (const auto& output : outputs) {
-            getOrCreateVar(output, solver, varMap);
-        }
-
-        // Apply CNF encoding for different gate types.
-        if (gateType == "buffer") {
-            // Buffer: Z = A
-            solver.addClause(mkLit(varMap[inputs[0]]), ~mkLit(varMap[outputs[0]]));
-            solver.addClause(~mkLit(varMap[inputs[0]]), mkLit(varMap[outputs[0]]));
-        } else if (gateType == "inv" || gateType == "not") {
-            // NOT: Z = ~A
-            solver.addClause(~mkLit(varMap[inputs[0]]), ~mkLit(varMap[outputs[0]]));
-            solver.addClause(mkLit(varMap[inputs[0]]), mkLit(varMap[outputs[0]]));
-        } else if (gateType.rfind("nor", 0) == 0) {
-            // NOR: Z = ~(A | B | ...)
-            clause.push(mkLit(varMap[outputs[0]]));
-            for (const auto& input : inputs) {
-                clause.push(mkLit(varMap[input]));
-                solver.addClause(~mkLit(varMap[input]), ~mkLit(varMap[outputs[0]]));
-            }
-            solver.addClause(clause);
-        } else if (gateType.rfind("or", 0) == 0) {
-            // OR: Z = A | B | ...
-            clause.clear();
-            clause.push(~mkLit(varMap[outputs[0]]));
-            for (const auto& input : inputs) {
-                clause.push(mkLit(varMap[input]));
-                solver.addClause(~mkLit(varMap[input]), mkLit(varMap[outputs[0]]));
+    }
+
+    Var inputVar(size_t i) const { return inputVars[i]; }
+
+    MiterEncoder* spawn() const {
+        return new NetlistMiterEncoder(spec.nl, spec.ports, imp.nl, imp.ports, inputVars.size(), specLits.size());
+    }
+
+    size_t coneSize(size_t output) const {
+        vector<int> roots, cone;
+        vector<char> specVisited(spec.nl.numGates(), 0), impVisited(imp.nl.numGates(), 0);
+        roots.push_back(spec.ports.outNets[output]);
+        collectCone(spec.nl, roots, specVisited, cone);
+        roots[0] = imp.ports.outNets[output];
+        collectCone(imp.nl, roots, impVisited, cone);
+        return cone.size();
+    }
+
+    size_t numEncoded() const { return spec.numEncoded + imp.numEncoded; }
+
+    void freezeInputs(CnfSolver& solver) const {
+        for (Var v : inputVars)
+            if (v != var_Undef)
+                solver.setFrozen(v, true);
+    }
+
+    void writeSymbols(ostream& out, const vector<string>& inputs, const vector<string>&) const {
+        for (size_t i = 0; i < inputs.size(); i++)
+            if (inputVars[i] != var_Undef)
+                out << inputVars[i] + 1 << " " << inputs[i] << endl;
+        const CnfNetlist* sides[2] = {&spec, &imp};
+        const char* prefix[2] = {"spec:", "impl:"};
+        for (int k = 0; k < 2; k++) {
+            const CnfNetlist& c = *sides[k];
+            for (size_t net = 0; net < c.netVars.size(); net++)
+                if (c.netVars[net] != var_Undef && c.ports.piIndex[net] < 0)
+                    out << c.netVars[net] + 1 << " " << prefix[k] << c.nl.netNames[net] << endl;
+        }
+    }
+
+    vector<Var> inputVars;      // Shared primary inputs.
+    CnfNetlist spec, imp;       // Internal signals for each circuit.
+};
+
+//--------------------------------------------------------------------
+// Structural hashing. Both flat netlists are built into one AIG that
+// shares the primary inputs, so logic that is identical in spec and impl
+// becomes the same node.
+
+// AIG of a truth table over ins[0 .. n), by Shannon expansion on the
+// last input: its cofactors are the two halves of the table.
+AigLit aigTruth(Aig& aig, uint64_t truth, const AigLit* ins, int n) {
+    uint64_t mask = n == 6 ? ~0ULL : (1ULL << (1 << n)) - 1;
+    truth &= mask;
+    if (truth == 0)
+        return AIG_FALSE;
+    if (truth == mask)
+        return AIG_TRUE;
+    int half = 1 << (n - 1);
+    uint64_t lo = truth & ((1ULL << half) - 1), hi = truth >> half;
+    if (lo == hi)
+        return aigTruth(aig, lo, ins, n - 1);
+    return aig.createMux(ins[n - 1], aigTruth(aig, hi, ins, n - 1), aigTruth(aig, lo, ins, n - 1));
+}
+
+// AIG of a single gate (the same cells as encodeGate).
+AigLit aigGate(Aig& aig, const CellDef& cell, const AigLit* ins, int numIns) {
+    GateType type = cell.type;
+    switch (type) {
+    case GATE_BUF:
+        return ins[0];
+    case GATE_INV:
+        return aigNot(ins[0]);
+    case GATE_AND: case GATE_NAND: case GATE_OR: case GATE_NOR: {
+        bool orType = type == GATE_OR || type == GATE_NOR;
+        AigLit res = orType ? AIG_FALSE : AIG_TRUE;
+        for (int k = 0; k < numIns; k++)
+            res = orType ? aig.createOr(res, ins[k]) : aig.createAnd(res, ins[k]);
+        return aigNotCond(res, type == GATE_NOR || type == GATE_NAND);
+    }
+    case GATE_XOR: case GATE_XNOR: {
+        AigLit res = ins[0];
+        for (int k = 1; k < numIns; k++)
+            res = aig.createXor(res, ins[k]);
+        return aigNotCond(res, type == GATE_XNOR);
+    }
+    case GATE_TABLE:
+        return aigTruth(aig, cell.truth, ins, numIns);
+    default:
+        // Flop outputs (and unsupported gates) are left unconstrained.
+        return aig.createInput();
+    }
+}
+
+// Add the cones of all outputs of a flat netlist to the AIG and return
+// their literals in rootLits. piLits holds the AIG inputs of the primary
+// inputs; VDD/VSS become the constant node.
+void buildAig(Aig& aig, const Netlist& nl, const MiterPorts& ports, const vector<AigLit>& piLits,
+              vector<AigLit>& rootLits) {
+    const AigLit noLit = ~0u;
+    vector<AigLit> netLits(nl.numNets(), noLit);
+    for (int net = 0; net < (int)nl.numNets(); net++)
+        if (ports.piIndex[net] >= 0)
+            netLits[net] = piLits[ports.piIndex[net]];
+    if (nl.vdd >= 0)
+        netLits[nl.vdd] = AIG_TRUE;
+    if (nl.vss >= 0)
+        netLits[nl.vss] = AIG_FALSE;
+    // Undriven nets are free inputs.
+    auto netLit = [&](int net) {
+        if (netLits[net] == noLit)
+            netLits[net] = aig.createInput();
+        return netLits[net];
+    };
+
+    vector<int> cone;
+    vector<char> visited(nl.numGates(), 0);
+    collectCone(nl, ports.outNets, visited, cone);
+    vector<AigLit> ins;
+    for (int g : cone) {
+        ins.clear();
+        for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+            ins.push_back(netLit(nl.fanins[k]));
+        netLits[nl.gateOuts[g]] = aigGate(aig, nl.lib.cell(nl.gateCells[g]), ins.data(), ins.size());
+    }
+    rootLits.clear();
+    for (int root : ports.outNets)
+        rootLits.push_back(netLit(root));
+}
+
+// Miter over the CNF of the shared AIG.
+class AigMiterEncoder : public MiterEncoder {
+public:
+    // specOuts/impOuts are filled by buildAig before the first encode().
+    AigMiterEncoder(const Aig& aig, const vector<AigLit>& specOuts, const vector<AigLit>& impOuts,
+                    const vector<AigLit>& piLits, size_t numOutputs)
+        : cnf(aig), specOuts(specOuts), impOuts(impOuts), piLits(piLits) {
+        specLits.assign(numOutputs, lit_Undef);
+        impLits.assign(numOutputs, lit_Undef);
+    }
+
+    void encode(CnfSolver& solver, const vector<size_t>& outs) {
+        for (size_t o : outs) {
+            specLits[o] = cnf.encode(solver, specOuts[o]);
+            impLits[o] = cnf.encode(solver, impOuts[o]);
+        }
+    }
+
+    Var inputVar(size_t i) const {
+        return i < piLits.size() ? cnf.nodeVar(aigNode(piLits[i])) : var_Undef;
+    }
+
+    MiterEncoder* spawn() const {
+        return new AigMiterEncoder(cnf.getAig(), specOuts, impOuts, piLits, specLits.size());
+    }
+
+    size_t coneSize(size_t output) const {
+        vector<AigLit> roots;
+        roots.push_back(specOuts[output]);
+        roots.push_back(impOuts[output]);
+        return cnf.getAig().coneSize(roots);
+    }
+
+    size_t numEncoded() const { return cnf.numEncoded(); }
+
+    void freezeInputs(CnfSolver& solver) const {
+        for (size_t i = 0; i < piLits.size(); i++)
+            if (inputVar(i) != var_Undef)
+                solver.setFrozen(inputVar(i), true);
+    }
+
+    // Internal AIG nodes have no names; only the inputs and the output
+    // literals of both sides are listed.
+    void writeSymbols(ostream& out, const vector<string>& inputs, const vector<string>& outputs) const {
+        for (size_t i = 0; i < piLits.size(); i++) {
+            Var v = inputVar(i);
+            if (v != var_Undef)
+                out << (aigIsCompl(piLits[i]) ? "-" : "") << v + 1 << " " << inputs[i] << endl;
+        }
+        for (size_t o = 0; o < outputs.size(); o++) {
+            if (specLits[o] == lit_Undef)
+                continue;
+            out << dimacsLit(specLits[o]) << " spec:" << outputs[o] << endl;
+            out << dimacsLit(impLits[o]) << " impl:" << outputs[o] << endl;
+        }
+    }
+
+    AigCnf cnf;
+
+private:
+    const vector<AigLit>& specOuts;
+    const vector<AigLit>& impOuts;
+    const vector<AigLit>& piLits;
+};
+
+//--------------------------------------------------------------------
+// Create a new difference variable d that is true if and only if the
+// spec output s and the impl output t differ (d <-> s XOR t).
+Var addDiffVar(CnfSolver& solver, Lit s, Lit t) {
+    Var d = solver.newVar();
+    Lit dLit = mkLit(d);
+    solver.addClause(~s, t, dLit);
+    solver.addClause(s, ~t, dLit);
+    solver.addClause(s, t, ~dLit);
+    solver.addClause(~s, ~t, ~dLit);
+    return d;
+}
+
+// Bounded variable elimination (-e) of an encoded miter, before its
+// first query. The inputs and cut points (read back as counterexamples)
+// and the diff variables (assumed and constrained by later queries) are
+// frozen; everything else may be resolved away.
+void preprocessMiter(CnfSolver& solver, const MiterEncoder& miter, const vector<Var>& diffVars,
+                     CheckStats& st) {
+    double wall = wallClock(), cpu = threadCpuClock();
+    miter.freezeInputs(solver);
+    for (Var d : diffVars)
+        if (d != var_Undef)
+            solver.setFrozen(d, true);
+    size_t clausesBefore = solver.nClauses();
+    int varsBefore = solver.eliminated_vars;
+    solver.eliminateOnce();
+    st.elimRuns++;
+    st.elimVars += solver.eliminated_vars - varsBefore;
+    st.elimClausesBefore += clausesBefore;
+    st.elimClausesAfter += solver.nClauses();
+    st.elimWall += wallClock() - wall;
+    st.elimCpu += threadCpuClock() - cpu;
+}
+
+// Encode the cones of 'outputs', one diff variable per output pair and
+// the clause that at least one differs; preprocess with -e.
+void encodeMiter(CnfSolver& solver, const vector<size_t>& outputs, MiterEncoder& miter, vector<Var>& diffVars,
+                 CheckStats& st) {
+    double wall = wallClock(), cpu = threadCpuClock();
+    miter.encode(solver, outputs);
+    diffVars.clear();
+    for (size_t o : outputs) {
+        // Create a new variable for the difference between this pair.
+        diffVars.push_back(addDiffVar(solver, miter.specLits[o], miter.impLits[o]));
+    }
+    // Force at least one difference to be true.
+    vec<Lit> miterClause;
+    for (Var d : diffVars)
+        miterClause.push(mkLit(d));
+    solver.addClause(miterClause);
+    st.encodeWall += wallClock() - wall;
+    st.encodeCpu += threadCpuClock() - cpu;
+    if (solver.canEliminate())
+        preprocessMiter(solver, miter, diffVars, st);
+}
+
+// Solver work done since 'before' was taken (zero counters give totals).
+SolverCounts solverCounts(const Solver& solver, const SolverCounts& before = SolverCounts()) {
+    SolverCounts c;
+    c.conflicts = solver.conflicts - before.conflicts;
+    c.decisions = solver.decisions - before.decisions;
+    c.propagations = solver.propagations - before.propagations;
+    return c;
+}
+
+// Primary input values of a counterexample, in port order: 0, 1, or -1
+// for inputs it leaves open.
+typedef vector<signed char> InputValues;
+
+// Print a primary input assignment; open inputs print undef.
+void printCounterExample(ostream& out, const vector<string>& primaryInputs, const InputValues& values) {
+    out << "Primary input assignment:" << endl;
+    for (size_t i = 0; i < primaryInputs.size(); i++)
+        out << primaryInputs[i] << " = " << (values[i] == 1 ? "1" : (values[i] == 0 ? "0" : "undef")) << endl;
+}
+
+// The primary inputs of the current solver model. Inputs outside every
+// encoded cone have no variable and are open.
+InputValues modelInputs(const Solver& solver, size_t numInputs, const MiterEncoder& miter) {
+    InputValues values(numInputs, -1);
+    for (size_t i = 0; i < numInputs; i++) {
+        Var v = miter.inputVar(i);
+        lbool val = v == var_Undef ? l_Undef : solver.modelValue(v);
+        if (val != l_Undef)
+            values[i] = val == l_True;
+    }
+    return values;
+}
+
+// Print a primary input assignment found by random simulation.
+void printSimCounterExample(ostream& out, const vector<string>& primaryInputs, const vector<bool>& values) {
+    printCounterExample(out, primaryInputs, InputValues(values.begin(), values.end()));
+}
+
+//--------------------------------------------------------------------
+// BDD engine (--bdd). An output whose two cones depend on at most
+// maxSupport variables (the primary inputs they read plus the free nets
+// of either side) is built as a BDD in both designs, with the variables
+// ordered by first use, and decided by comparing the two nodes; a path
+// of their XOR is a counterexample. Wider cones, and cones whose BDDs
+// reach BDD_MAX_NODES, are left to SAT.
+
+// BDD of a truth table over ins[0 .. n), by Shannon expansion on the
+// last input (as aigTruth).
+BddNode bddTruth(BddManager& bdd, uint64_t truth, const BddNode* ins, int n) {
+    uint64_t mask = n == 6 ? ~0ULL : (1ULL << (1 << n)) - 1;
+    truth &= mask;
+    if (truth == 0)
+        return BDD_FALSE;
+    if (truth == mask)
+        return BDD_TRUE;
+    int half = 1 << (n - 1);
+    uint64_t lo = truth & ((1ULL << half) - 1), hi = truth >> half;
+    if (lo == hi)
+        return bddTruth(bdd, lo, ins, n - 1);
+    return bdd.ite(ins[n - 1], bddTruth(bdd, hi, ins, n - 1), bddTruth(bdd, lo, ins, n - 1));
+}
+
+// BDD of a single combinational gate (the same cells as aigGate).
+BddNode bddGate(BddManager& bdd, const CellDef& cell, const BddNode* ins, int numIns) {
+    GateType type = cell.type;
+    switch (type) {
+    case GATE_BUF:
+        return ins[0];
+    case GATE_INV:
+        return bdd.bddNot(ins[0]);
+    case GATE_AND: case GATE_NAND: case GATE_OR: case GATE_NOR: {
+        bool orType = type == GATE_OR || type == GATE_NOR;
+        BddNode res = orType ? BDD_FALSE : BDD_TRUE;
+        for (int k = 0; k < numIns; k++)
+            res = orType ? bdd.bddOr(res, ins[k]) : bdd.bddAnd(res, ins[k]);
+        return type == GATE_NOR || type == GATE_NAND ? bdd.bddNot(res) : res;
+    }
+    case GATE_XOR: case GATE_XNOR: {
+        BddNode res = ins[0];
+        for (int k = 1; k < numIns; k++)
+            res = bdd.bddXor(res, ins[k]);
+        return type == GATE_XNOR ? bdd.bddNot(res) : res;
+    }
+    default:
+        return bddTruth(bdd, cell.truth, ins, numIns);
+    }
+}
+
+// Builds the BDDs of output cones of one design. Leaves get variables
+// on first use: primary inputs through the shared piVars, free nets
+// (undriven, flop and unsupported gate outputs) one each.
+struct BddCone {
+    const Netlist& nl;
+    const MiterPorts& ports;
+    vector<BddNode> netBdds;    // by net, BDD_INVALID if not built
+    vector<char> visited;       // by gate, scratch of collectCone
+    vector<int> cone, touched;
+    vector<BddNode> ins;
+    bool wide = false;          // the last build ran out of variables
+
+    BddCone(const Netlist& nl, const MiterPorts& ports)
+        : nl(nl), ports(ports), netBdds(nl.numNets(), BDD_INVALID), visited(nl.numGates(), 0) {}
+
+    // Variable of a leaf net; false once more than maxVars are in use.
+    bool leaf(int net, BddManager& bdd, vector<int>& piVars, vector<int>& varPis, size_t maxVars) {
+        if (netBdds[net] != BDD_INVALID)
+            return true;
+        touched.push_back(net);
+        if (net == nl.vdd || net == nl.vss) {
+            netBdds[net] = net == nl.vdd ? BDD_TRUE : BDD_FALSE;
+            return true;
+        }
+        int pi = ports.piIndex[net];
+        if (pi < 0 || piVars[pi] < 0) {
+            if (varPis.size() >= maxVars) {
+                wide = true;
+                return false;
             }
-            solver.addClause(clause);
-        } else if (gateType.rfind("nand", 0) == 0) {
-            // NAND: Z = ~(A & B & ...)
-            clause.clear();
-            clause.push(~mkLit(varMap[outputs[0]]));
-            for (const auto& input : inputs) {
-                clause.push(~mkLit(varMap[input]));
-                solver.addClause(mkLit(varMap[input]), mkLit(varMap[outputs[0]]));
+            if (pi >= 0)
+                piVars[pi] = varPis.size();
+            varPis.push_back(pi);
+        }
+        netBdds[net] = bdd.var(pi >= 0 ? piVars[pi] : varPis.size() - 1);
+        return true;
+    }
+
+    // BDD of net 'root', BDD_INVALID if it needs more than maxVars
+    // variables or the node limit is reached. varPis[v] is the primary
+    // input of variable v (-1 for free nets).
+    BddNode build(int root, BddManager& bdd, vector<int>& piVars, vector<int>& varPis, size_t maxVars) {
+        vector<int> roots(1, root);
+        cone.clear();
+        collectCone(nl, roots, visited, cone);
+        for (int g : cone)
+            visited[g] = 0;
+        BddNode res = BDD_INVALID;
+        bool ok = true;
+        for (size_t i = 0; ok && i < cone.size(); i++) {
+            int g = cone[i];
+            GateType type = nl.gateTypes[g];
+            if (type == GATE_DFF || type == GATE_UNKNOWN) {
+                ok = leaf(nl.gateOuts[g], bdd, piVars, varPis, maxVars);
+                continue;
             }
-            solver.addClause(clause);
-        } else if (gateType.rfind("and", 0) == 0) {
-            // AND: Z = A & B & ...
-            clause.clear();
-            clause.push(mkLit(varMap[outputs[0]]));
-            for (const auto& input : inputs) {
-                clause.push(~mkLit(varMap[input]));
-                solver.addClause(mkLit(varMap[input]), ~mkLit(varMap[outputs[0]]));
+            ins.clear();
+            for (int k = nl.gateFaninBegin(g); ok && k < nl.gateFaninEnd(g); k++) {
+                int net = nl.fanins[k];
+                ok = leaf(net, bdd, piVars, varPis, maxVars);
+                ins.push_back(netBdds[net]);
             }
-            solver.addClause(clause);
-        } else if (gateType == "xor" || gateType == "xor2") {
-            // XOR: Z = A ^ B (assumes exactly 2 inputs)
-            solver.addClause(~mkLit(varMap[inputs[0]]), ~mkLit(varMap[inputs[1]]), ~mkLit(varMap[outputs[0]]));
-            solver.addClause(mkLit(varMap[inputs[0]]), mkLit(varMap[inputs[1]]), ~mkLit(varMap[outputs[0]]));
-            solver.addClause(mkLit(varMap[inputs[0]]), ~mkLit(varMap[inputs[1]]), mkLit(varMap[outputs[0]]));
-            solver.addClause(~mkLit(varMap[inputs[0]]), mkLit(varMap[inputs[1]]), mkLit(varMap[outputs[0]]));
-        } else if (gateType == "dff") {
-            // D Flip-Flop: We *Do not add any constraint* so that the sequential behavior does not mask differences.
-            // (Alternatively, add a fixed initial state, e.g., force Q = false.)
-            // For now, we do nothing so that the combinational differences are visible.
-            // If you want a fixed initial state, uncomment one of the lines below:
-            // solver.addClause(~mkLit(varMap[outputs[0]]));  // forces Q = 0
-            // or
-            // solver.addClause(mkLit(varMap[outputs[0]]));   // forces Q = 1
+            if (!ok)
+                break;
+            BddNode f = bddGate(bdd, nl.lib.cell(nl.gateCells[g]), ins.data(), ins.size());
+            ok = f != BDD_INVALID;
+            touched.push_back(nl.gateOuts[g]);
+            netBdds[nl.gateOuts[g]] = f;
+        }
+        if (ok && leaf(root, bdd, piVars, varPis, maxVars))
+            res = netBdds[root];
+        return res;
+    }
 
-        } else {
-            cerr << "-E- Unsupported gate type: " << gateType << endl;
+    void reset() {
+        for (int net : touched)
+            netBdds[net] = BDD_INVALID;
+        touched.clear();
+        wide = false;
+    }
+};
+
+struct BddCheckStats {
+    size_t proven = 0, failed = 0;
+    size_t tooWide = 0, tooLarge = 0;   // left to SAT
+    size_t peakNodes = 0;
+};
+
+// Decide the outputs in 'toCheck' on BDDs where their support allows.
+// results[o] and cexs[o] are set for the outputs decided; the others
+// stay unknown.
+void checkOutputsByBdd(const Netlist& specNl, const MiterPorts& specPorts, const Netlist& impNl,
+                       const MiterPorts& impPorts, size_t numInputs, const vector<size_t>& toCheck,
+                       size_t maxSupport, vector<OutputStatus>& results, vector<InputValues>& cexs,
+                       BddCheckStats& st) {
+    BddManager bdd(BDD_MAX_NODES);
+    BddCone spec(specNl, specPorts), imp(impNl, impPorts);
+    vector<int> piVars(numInputs, -1), varPis;
+    vector<signed char> path;
+    for (size_t o : toCheck) {
+        bdd.clear();
+        varPis.clear();
+        BddNode s = spec.build(specPorts.outNets[o], bdd, piVars, varPis, maxSupport);
+        BddNode t = s == BDD_INVALID ? BDD_INVALID
+                                     : imp.build(impPorts.outNets[o], bdd, piVars, varPis, maxSupport);
+        BddNode diff = t == BDD_INVALID ? BDD_INVALID : bdd.bddXor(s, t);
+        st.peakNodes = max(st.peakNodes, bdd.numNodes());
+        bool wide = spec.wide || imp.wide;
+        spec.reset();
+        imp.reset();
+        for (int pi : varPis)
+            if (pi >= 0)
+                piVars[pi] = -1;
+        if (diff == BDD_INVALID) {
+            (wide ? st.tooWide : st.tooLarge)++;
+            continue;
+        }
+        if (diff == BDD_FALSE) {
+            results[o] = OUT_PROVEN;
+            st.proven++;
+            continue;
         }
+        path.clear();
+        bdd.satisfy(diff, path);
+        InputValues cex(numInputs, -1);
+        for (size_t v = 0; v < path.size(); v++)
+            if (varPis[v] >= 0 && path[v] >= 0)
+                cex[varPis[v]] = path[v];
+        results[o] = OUT_FAILED;
+        cexs[o] = cex;
+        st.failed++;
     }
 }
 
@@ -174,169 +736,1636 @@ void generateCNF(hcmCell* cell, Solver& solver, map<string, Var>& varMap,
 // For each output pair, create a new difference variable d that is true
 // if and only if the spec and impl outputs differ. Then add a clause
 // requiring that at least one difference is true.
+// Only the given outputs take part; if there are none (e.g. all were
+// proven structurally) the miter clause is empty and the solver is UNSAT
+// without any search.
 // If SAT, print a counter-example (the primary input assignments).
-bool checkEquivalence(Solver& solver, 
+// The query runs under queryBudget, with escalating retries; if it is
+// still undecided the result is OUT_UNKNOWN.
+// diffVars receives the difference variable of each checked output,
+// 'cex' the counterexample and 'st' the encoding and solving effort; the
+// report goes to 'out'.
+OutputStatus checkEquivalence(CnfSolver& solver, 
                       const vector<string>& primaryInputs,
-                      const vector<string>& outputsSpec, const vector<string>& outputsImp,
-                      const map<string, Var>& varMapSpec, const map<string, Var>& varMapImp) {
-    vector<Var> diffVars;
-    for (size_t i = 0; i < outputsSpec.size(); i++) {
-        // Create a new variable for the difference between this pair.
-        Var d = solver.newVar();
-        diffVars.push_back(d);
-        Lit s = mkLit(varMapSpec.at(outputsSpec[i]));
-        Lit t = mkLit(varMapImp.at(outputsImp[i]));
-        Lit dLit = mkLit(d);
-        // Encode: d is true iff s XOR t is true.
-        solver.addClause(~s, t, dLit);
-        solver.addClause(s, ~t, dLit);
-        solver.addClause(s, t, ~dLit);
-        solver.addClause(~s, ~t, ~dLit);
-    }
-    // Force at least one difference to be true.
-    vec<Lit> miterClause;
-    for (Var d : diffVars)
-        miterClause.push(mkLit(d));
-    solver.addClause(miterClause);
+                      const vector<size_t>& outputs, MiterEncoder& miter, vector<Var>& diffVars,
+                      InputValues& cex, CheckStats& st, ostream& out) {
+    encodeMiter(solver, outputs, miter, diffVars, st);
 
     // Check for satisfiability.
-    if (solver.solve()) {
-        cout << "\nA counterexample was found:" << endl;
-        cout << "Primary input assignment:" << endl;
-        // For each primary input, print its assigned value.
-        for (const auto& in : primaryInputs) {
-            // We assume that the primary input is shared in varMapSpec.
-            Var v = varMapSpec.at(in);
-            lbool val = solver.modelValue(v);
-            cout << in << " = " << (val == l_True ? "1" : (val == l_False ? "0" : "undef")) << endl;
-        }
-        cout << endl;
+    double wall = wallClock(), cpu = threadCpuClock();
+    Budget budget = queryBudget;
+    lbool ret;
+    for (int pass = 0;; pass++) {
+        ret = solveWithBudget(solver, vec<Lit>(), budget);
+        if (ret != l_Undef || pass >= budgetRetries || !budget.limited() || runStopped())
+            break;
+        budget = budget.scaled(BUDGET_ESCALATION);
+        out << "-I- Retrying the miter with a budget of " << budget.describe() << endl;
+    }
+    st.solveWall += wallClock() - wall;
+    st.solveCpu += threadCpuClock() - cpu;
+    st.vars += solver.nVars();
+    st.clauses += solver.nClauses();
+    st.counts.add(solverCounts(solver));
+    if (ret == l_True) {
+        out << "\nA counterexample was found:" << endl;
+        cex = modelInputs(solver, primaryInputs.size(), miter);
+        printCounterExample(out, primaryInputs, cex);
+        out << endl;
+        return OUT_FAILED;
+    } else if (ret == l_False) {
+        out << endl;
+        return OUT_PROVEN;
+    }
+    out << "-I- The miter was not decided (" << (runStopped() ? runStopReason() : "budget exhausted")
+         << ")" << endl << endl;
+    return OUT_UNKNOWN;
+}
+
+//--------------------------------------------------------------------
+// Cube and conquer (--cubes D) of the single miter, for outputs too
+// hard for one solver. A warm-up query of CUBE_WARMUP_CONFLICTS
+// conflicts on 'solver' ranks the variables by VSIDS activity; the D
+// most active ones still unassigned split the miter into 2^D cubes.
+// numThreads workers each encode the same miter into a solver of their
+// own (the encoding is deterministic, so the variables agree) and solve
+// cubes under assumptions, on the work-stealing pool. The first
+// satisfiable cube cancels the others and its model is copied to
+// 'solver'. Cubes run under queryBudget without retries; if none is
+// satisfiable and some are undecided the result is OUT_UNKNOWN.
+OutputStatus checkEquivalenceCubes(CnfSolver& solver, const vector<string>& primaryInputs,
+                                   const vector<size_t>& outputs, MiterEncoder& miter, vector<Var>& diffVars,
+                                   int depth, int numThreads, InputValues& cex, CheckStats& st, ostream& out) {
+    encodeMiter(solver, outputs, miter, diffVars, st);
+
+    // Warm-up: easy miters end here, the others leave their activities.
+    double wall = wallClock(), cpu = threadCpuClock();
+    Budget warmup;
+    warmup.conflicts = CUBE_WARMUP_CONFLICTS;
+    lbool ret = solveWithBudget(solver, vec<Lit>(), warmup);
+    st.solveWall += wallClock() - wall;
+    st.solveCpu += threadCpuClock() - cpu;
+    st.vars += solver.nVars();
+    st.clauses += solver.nClauses();
+    st.counts.add(solverCounts(solver));
+    if (ret == l_True) {
+        out << "-I- Cubes: the warm-up found a counterexample" << endl;
+        out << "\nA counterexample was found:" << endl;
+        cex = modelInputs(solver, primaryInputs.size(), miter);
+        printCounterExample(out, primaryInputs, cex);
+        out << endl;
+        return OUT_FAILED;
+    } else if (ret == l_False) {
+        out << "-I- Cubes: the warm-up proved the miter" << endl << endl;
+        return OUT_PROVEN;
+    } else if (runStopped()) {
+        out << "-I- The miter was not decided (" << runStopReason() << ")" << endl << endl;
+        return OUT_UNKNOWN;
+    }
+
+    vector<Var> splitVars;
+    for (Var v = 0; v < solver.nVars(); v++)
+        if (solver.value(v) == l_Undef && !solver.isEliminated(v))
+            splitVars.push_back(v);
+    depth = min(depth, (int)splitVars.size());
+    partial_sort(splitVars.begin(), splitVars.begin() + depth, splitVars.end(),
+                 [&](Var a, Var b) { return solver.varActivity(a) > solver.varActivity(b); });
+    splitVars.resize(depth);
+    size_t numSplitInputs = 0;
+    for (size_t i = 0; i < primaryInputs.size(); i++)
+        if (miter.inputVar(i) != var_Undef &&
+            find(splitVars.begin(), splitVars.end(), miter.inputVar(i)) != splitVars.end())
+            numSplitInputs++;
+    size_t numCubes = (size_t)1 << depth;
+    out << "-I- Cubes: split on " << depth << " variables (" << numSplitInputs << " primary inputs) after "
+        << CUBE_WARMUP_CONFLICTS << " warm-up conflicts: " << numCubes << " cubes on " << numThreads
+        << " threads" << endl;
+
+    struct Worker {
+        unique_ptr<MiterEncoder> miter;
+        unique_ptr<CnfSolver> solver;
+        CheckStats st;
+    };
+    mutex lock;
+    vector<unique_ptr<Worker>> workers;
+    vector<Worker*> idle;
+    atomic<bool> found(false);
+    size_t numUnsat = 0, numSat = 0, numUndecided = 0, numSkipped = 0, satCube = 0;
+    vector<size_t> order(numCubes);
+    for (size_t c = 0; c < numCubes; c++)
+        order[c] = c;
+    runWorkStealing(order, numThreads, [&](size_t cube) {
+        Worker* w = NULL;
+        {
+            lock_guard<mutex> guard(lock);
+            if (found || runStopped()) {
+                numSkipped++;
+                return;
+            }
+            if (idle.empty()) {
+                workers.push_back(unique_ptr<Worker>(new Worker));
+                w = workers.back().get();
+            } else {
+                w = idle.back();
+                idle.pop_back();
+            }
+        }
+        if (!w->solver) {
+            w->miter.reset(miter.spawn());
+            w->solver.reset(new CnfSolver(preprocessCnf));
+            vector<Var> workerDiffs;
+            encodeMiter(*w->solver, outputs, *w->miter, workerDiffs, w->st);
+        }
+        vec<Lit> assumps;
+        for (int k = 0; k < depth; k++)
+            assumps.push(mkLit(splitVars[k], !((cube >> k) & 1)));
+        double wall = wallClock(), cpu = threadCpuClock();
+        lbool ret = solveWithBudget(*w->solver, assumps, queryBudget, &found);
+        w->st.solveWall += wallClock() - wall;
+        w->st.solveCpu += threadCpuClock() - cpu;
+
+        lock_guard<mutex> guard(lock);
+        if (ret == l_True) {
+            numSat++;
+            if (!found) {
+                found = true;
+                satCube = cube;
+                w->solver->model.copyTo(solver.model);
+                cex = modelInputs(*w->solver, primaryInputs.size(), *w->miter);
+            }
+        } else if (ret == l_False) {
+            numUnsat++;
+        } else if (found) {
+            numSkipped++;
+        } else {
+            numUndecided++;
+        }
+        idle.push_back(w);
+    });
+    for (const auto& w : workers) {
+        st.add(w->st);
+        st.vars += w->solver->nVars();
+        st.clauses += w->solver->nClauses();
+        st.counts.add(solverCounts(*w->solver));
+    }
+    out << "-I- Cubes: " << numUnsat << " unsatisfiable, " << numSat << " satisfiable, " << numUndecided
+        << " undecided, " << numSkipped << " cancelled or not run";
+    if (found)
+        out << " (cube " << satCube << " satisfiable first)";
+    out << endl;
+
+    if (found) {
+        out << "\nA counterexample was found:" << endl;
+        printCounterExample(out, primaryInputs, cex);
+        out << endl;
+        return OUT_FAILED;
+    }
+    if (numUnsat == numCubes) {
+        out << endl;
+        return OUT_PROVEN;
+    }
+    out << "-I- The miter was not decided (" << (runStopped() ? runStopReason() : "budget exhausted")
+         << ")" << endl << endl;
+    return OUT_UNKNOWN;
+}
+
+//--------------------------------------------------------------------
+// All failing outputs of the single miter (--cex). Once the miter is
+// satisfiable, the same solver is asked again whether one of the
+// outputs not failed yet can differ: each round adds a fresh activation
+// variable a and the clause (~a | d...) over those outputs, and solves
+// under a alone. The outputs already failed stay unconstrained, so an
+// output that only differs together with one of them is still found.
+// Every model exposes at least one more failing output, which gets that
+// model as its counterexample; once the query is unsatisfiable the rest
+// are proven. The used clause is disabled with the unit ~a. The queries
+// run under queryBudget; if one is undecided the rest stay OUT_UNKNOWN.
+void enumerateFailures(CnfSolver& solver, const vector<string>& primaryInputs, const vector<string>& outputs,
+                       const vector<size_t>& openOutputs, const MiterEncoder& miter, const vector<Var>& diffVars,
+                       vector<OutputStatus>& results, vector<InputValues>& cexs, CheckStats& st, ostream& out) {
+    SolverCounts before = solverCounts(solver);
+    size_t numQueries = 0;
+    for (;;) {
+        Var act = solver.newVar();
+        vec<Lit> clause;
+        clause.push(mkLit(act, true));
+        for (size_t k = 0; k < openOutputs.size(); k++)
+            if (results[openOutputs[k]] != OUT_FAILED)
+                clause.push(mkLit(diffVars[k]));
+        if (clause.size() == 1)
+            break;
+        solver.addClause(clause);
+        vec<Lit> assumps;
+        assumps.push(mkLit(act));
+        double wall = wallClock(), cpu = threadCpuClock();
+        lbool ret = solveWithBudget(solver, assumps, queryBudget);
+        st.solveWall += wallClock() - wall;
+        st.solveCpu += threadCpuClock() - cpu;
+        numQueries++;
+        solver.addClause(mkLit(act, true));
+        if (ret == l_False) {
+            for (size_t o : openOutputs)
+                if (results[o] == OUT_UNKNOWN)
+                    results[o] = OUT_PROVEN;
+            break;
+        } else if (ret == l_Undef) {
+            out << "-I- Enumeration stopped (" << (runStopped() ? runStopReason() : "budget exhausted")
+                << "); the outputs not failed are UNKNOWN" << endl;
+            break;
+        }
+        InputValues cex = modelInputs(solver, primaryInputs.size(), miter);
+        bool first = true;
+        for (size_t k = 0; k < openOutputs.size(); k++) {
+            size_t o = openOutputs[k];
+            if (results[o] == OUT_FAILED || solver.modelValue(diffVars[k]) != l_True)
+                continue;
+            results[o] = OUT_FAILED;
+            cexs[o] = cex;
+            if (first) {
+                out << "\nA counterexample was found for output " << outputs[o] << ":" << endl;
+                printCounterExample(out, primaryInputs, cex);
+                first = false;
+            } else {
+                out << "The same assignment also exposes output " << outputs[o] << endl;
+            }
+        }
+    }
+    st.counts.add(solverCounts(solver, before));
+    size_t numFailed = 0;
+    for (size_t o : openOutputs)
+        numFailed += results[o] == OUT_FAILED;
+    out << "-I- Enumeration: " << numFailed << " failing outputs after " << numQueries << " more queries" << endl;
+}
+
+// Assumption-based minimization of the counterexample of one failed
+// output (--cex). 'solver' holds the output's cones and its diff
+// variable d, without a miter clause. The input values of 'cex' force
+// the difference exactly when they are unsatisfiable together with ~d;
+// the final conflict then names the inputs that were needed. Each input
+// left is dropped in turn if the others still force the difference, so
+// the result is irredundant up to the queries that hit
+// CEX_MINIMIZE_CONF_LIMIT. The inputs dropped become open (-1). Returns
+// false, leaving 'cex' as is, if it does not force the difference (it
+// then relies on free nets) or that could not be decided.
+bool minimizeCounterExample(CnfSolver& solver, const MiterEncoder& miter, Var diff, InputValues& cex,
+                            size_t& numQueries) {
+    vector<size_t> ins;
+    for (size_t i = 0; i < cex.size(); i++)
+        if (cex[i] >= 0 && miter.inputVar(i) != var_Undef)
+            ins.push_back(i);
+    vector<char> inConflict(solver.nVars(), 0);
+    // Whether the values of 'set' force the difference; if they do, 'set'
+    // shrinks to the inputs in the final conflict.
+    auto forces = [&](vector<size_t>& set, const Budget& budget) {
+        vec<Lit> assumps;
+        assumps.push(mkLit(diff, true));
+        for (size_t i : set)
+            assumps.push(mkLit(miter.inputVar(i), !cex[i]));
+        numQueries++;
+        if (solveWithBudget(solver, assumps, budget) != l_False)
+            return false;
+        for (int k = 0; k < solver.conflict.size(); k++)
+            inConflict[var(solver.conflict[k])] = 1;
+        vector<size_t> kept;
+        for (size_t i : set)
+            if (inConflict[miter.inputVar(i)])
+                kept.push_back(i);
+        for (int k = 0; k < solver.conflict.size(); k++)
+            inConflict[var(solver.conflict[k])] = 0;
+        set.swap(kept);
+        return true;
+    };
+    if (!forces(ins, queryBudget))
         return false;
-    } else{
-        cout << endl;
+    Budget dropBudget;
+    dropBudget.conflicts = CEX_MINIMIZE_CONF_LIMIT;
+    vector<char> needed(cex.size(), 0);
+    for (;;) {
+        auto it = find_if(ins.begin(), ins.end(), [&](size_t i) { return !needed[i]; });
+        if (it == ins.end() || runStopped())
+            break;
+        vector<size_t> trial(ins.begin(), it);
+        trial.insert(trial.end(), it + 1, ins.end());
+        if (forces(trial, dropBudget))
+            ins.swap(trial);
+        else
+            needed[*it] = 1;
+    }
+    InputValues minimal(cex.size(), -1);
+    for (size_t i : ins)
+        minimal[i] = cex[i];
+    cex.swap(minimal);
+    return true;
+}
+
+//--------------------------------------------------------------------
+// Incremental per-output check. All outputs share one solver: each PO
+// pair (or group of groupSize pairs) is checked by solve(assumptions) on
+// its diff literal, so clauses learned by one query are reused by the
+// next. A group is activated by a fresh literal a with the clause
+// (~a | d_1 | ... | d_k). Proven outputs get the unit clause ~d, which
+// tells later queries that the two outputs are equal.
+// Only the cones of influence of the group's outputs are encoded before
+// each query, on top of the gates already in the solver (with -e, all
+// of them before the first query).
+// Only the outputs in 'toCheck' are checked; results[i] receives the
+// verdict of output i and no other entry is read or written, so jobs
+// over disjoint outputs can share one results vector. Counterexamples
+// are printed to 'log' and stored in cexs (written like results). The
+// solver work of each query is added to outStats of its outputs
+// (written like results) and to 'st'.
+// Queries run under queryBudget. Groups that run out are retried after
+// all others, with an escalated budget; groups still undecided after
+// the last retry, or when the run is stopped, stay unknown.
+// The return value is true only if every checked output was proven.
+bool checkEquivalencePerOutput(CnfSolver& solver,
+                               const vector<string>& primaryInputs, const vector<string>& outputs,
+                               const vector<size_t>& toCheck, MiterEncoder& miter, size_t groupSize,
+                               vector<OutputStatus>& results, vector<InputValues>& cexs,
+                               vector<OutputStats>& outStats, CheckStats& st, ostream& log) {
+    size_t numOutputs = outputs.size();
+    vector<Var> diffVars(numOutputs, var_Undef);
+    if (groupSize < 1)
+        groupSize = 1;
+
+    // Work list of output groups, in output order.
+    deque<vector<size_t>> pending;
+    vector<size_t> group;
+    for (size_t i : toCheck) {
+        results[i] = OUT_UNKNOWN;
+        group.push_back(i);
+        if (group.size() == groupSize) {
+            pending.push_back(group);
+            group.clear();
+        }
+    }
+    if (!group.empty())
+        pending.push_back(group);
+
+    // With variable elimination the whole miter is encoded up front and
+    // preprocessed once; the queries then only add clauses over frozen
+    // and new variables.
+    if (solver.canEliminate()) {
+        double wall = wallClock(), cpu = threadCpuClock();
+        miter.encode(solver, toCheck);
+        for (size_t o : toCheck)
+            diffVars[o] = addDiffVar(solver, miter.specLits[o], miter.impLits[o]);
+        st.encodeWall += wallClock() - wall;
+        st.encodeCpu += threadCpuClock() - cpu;
+        preprocessMiter(solver, miter, diffVars, st);
+    }
+
+    Budget budget = queryBudget;
+    vector<vector<size_t>> undecided;
+    for (int pass = 0;; pass++) {
+        while (!pending.empty() && !runStopped()) {
+            vector<size_t> group = pending.front();
+            pending.pop_front();
+            // An earlier counterexample may already have exposed some of them.
+            vector<size_t> open;
+            for (size_t o : group)
+                if (results[o] == OUT_UNKNOWN)
+                    open.push_back(o);
+            if (open.empty())
+                continue;
+
+            // Bring the cones of the new outputs into the solver.
+            double wall = wallClock(), cpu = threadCpuClock();
+            vector<size_t> fresh;
+            for (size_t o : open)
+                if (diffVars[o] == var_Undef)
+                    fresh.push_back(o);
+            miter.encode(solver, fresh);
+            for (size_t o : fresh)
+                diffVars[o] = addDiffVar(solver, miter.specLits[o], miter.impLits[o]);
+
+            vec<Lit> assumps;
+            Lit act = lit_Undef;
+            if (open.size() == 1) {
+                assumps.push(mkLit(diffVars[open[0]]));
+            } else {
+                act = mkLit(solver.newVar());
+                vec<Lit> groupClause;
+                groupClause.push(~act);
+                for (size_t o : open)
+                    groupClause.push(mkLit(diffVars[o]));
+                solver.addClause(groupClause);
+                assumps.push(act);
+            }
+            st.encodeWall += wallClock() - wall;
+            st.encodeCpu += threadCpuClock() - cpu;
+
+            wall = wallClock();
+            cpu = threadCpuClock();
+            SolverCounts before = solverCounts(solver);
+            lbool ret = solveWithBudget(solver, assumps, budget);
+            double solveWall = wallClock() - wall;
+            SolverCounts work = solverCounts(solver, before);
+            st.solveWall += solveWall;
+            st.solveCpu += threadCpuClock() - cpu;
+            for (size_t o : open) {
+                outStats[o].queries++;
+                outStats[o].counts.add(work);
+                outStats[o].solveSeconds += solveWall;
+            }
+            if (ret == l_False) {
+                for (size_t o : open) {
+                    results[o] = OUT_PROVEN;
+                    solver.addClause(~mkLit(diffVars[o]));
+                }
+            } else if (ret == l_True) {
+                // Every open output whose diff is true in this model fails.
+                InputValues cex = modelInputs(solver, primaryInputs.size(), miter);
+                bool printed = false;
+                for (size_t o : toCheck) {
+                    if (diffVars[o] == var_Undef || results[o] != OUT_UNKNOWN ||
+                        solver.modelValue(diffVars[o]) != l_True)
+                        continue;
+                    results[o] = OUT_FAILED;
+                    cexs[o] = cex;
+                    if (!printed) {
+                        log << "\nA counterexample was found for output " << outputs[o] << ":" << endl;
+                        printCounterExample(log, primaryInputs, cex);
+                        printed = true;
+                    } else {
+                        log << "The same assignment also exposes output " << outputs[o] << endl;
+                    }
+                }
+                vector<size_t> rest;
+                for (size_t o : open)
+                    if (results[o] == OUT_UNKNOWN)
+                        rest.push_back(o);
+                if (!rest.empty())
+                    pending.push_front(rest);
+            } else {
+                // Out of budget or interrupted: the group stays unknown for now.
+                undecided.push_back(open);
+            }
+
+            // Retire the group clause so it does not constrain later queries.
+            if (act != lit_Undef)
+                solver.addClause(~act);
+        }
+        if (undecided.empty() || pass >= budgetRetries || !budget.limited() || runStopped())
+            break;
+        budget = budget.scaled(BUDGET_ESCALATION);
+        log << "-I- Retrying " << undecided.size() << " undecided quer" << (undecided.size() == 1 ? "y" : "ies")
+            << " with a budget of " << budget.describe() << endl;
+        pending.assign(undecided.begin(), undecided.end());
+        undecided.clear();
+    }
+    log << endl;
+    st.vars += solver.nVars();
+    st.clauses += solver.nClauses();
+    st.counts.add(solverCounts(solver));
+
+    bool allProven = true;
+    for (size_t o : toCheck)
+        if (results[o] != OUT_PROVEN)
+            allProven = false;
+    return allProven;
+}
+
+//--------------------------------------------------------------------
+// Parallel per-output check. The open outputs are split into jobs, each
+// checked by checkEquivalencePerOutput with its own solver and its own
+// encoder, so a job only encodes its own cones. Outputs whose cones cost
+// at least JOB_BATCH_COST gates/nodes get a job of their own; cheaper
+// ones are batched in output order until a batch reaches that cost.
+// Jobs start in decreasing cost order on a work-stealing pool.
+// The jobs depend only on the outputs, never on the number of threads,
+// and each job's log is printed in job order, so the results and the
+// output are the same for every thread count.
+bool checkEquivalenceParallel(const vector<string>& primaryInputs, const vector<string>& outputs,
+                              const vector<size_t>& toCheck, const MiterEncoder& proto,
+                              size_t groupSize, int numThreads, vector<OutputStatus>& results,
+                              vector<InputValues>& cexs, vector<OutputStats>& outStats, CheckStats& st,
+                              ostream& out) {
+    vector<vector<size_t>> jobs;
+    vector<size_t> jobCost;
+    vector<size_t> batch;
+    size_t batchCost = 0;
+    for (size_t o : toCheck) {
+        size_t cost = proto.coneSize(o);
+        if (cost >= JOB_BATCH_COST) {
+            jobs.push_back(vector<size_t>(1, o));
+            jobCost.push_back(cost);
+            continue;
+        }
+        batch.push_back(o);
+        batchCost += cost;
+        if (batchCost >= JOB_BATCH_COST) {
+            jobs.push_back(batch);
+            jobCost.push_back(batchCost);
+            batch.clear();
+            batchCost = 0;
+        }
+    }
+    if (!batch.empty()) {
+        jobs.push_back(batch);
+        jobCost.push_back(batchCost);
+    }
+
+    vector<size_t> order(jobs.size());
+    for (size_t j = 0; j < jobs.size(); j++)
+        order[j] = j;
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return jobCost[a] > jobCost[b]; });
+
+    vector<string> logs(jobs.size());
+    vector<size_t> encoded(jobs.size(), 0);
+    vector<char> jobProven(jobs.size(), 0);
+    vector<CheckStats> jobStats(jobs.size());
+    size_t steals = runWorkStealing(order, numThreads, [&](size_t j) {
+        CnfSolver solver(preprocessCnf);
+        unique_ptr<MiterEncoder> miter(proto.spawn());
+        ostringstream log;
+        jobProven[j] = checkEquivalencePerOutput(solver, primaryInputs, outputs, jobs[j], *miter, groupSize,
+                                                 results, cexs, outStats, jobStats[j], log);
+        logs[j] = log.str();
+        encoded[j] = miter->numEncoded();
+    });
+
+    bool allProven = true;
+    size_t totalEncoded = 0;
+    for (size_t j = 0; j < jobs.size(); j++) {
+        out << logs[j];
+        totalEncoded += encoded[j];
+        st.add(jobStats[j]);
+        allProven = allProven && jobProven[j];
+    }
+    out << "-I- Parallel: " << jobs.size() << " jobs on " << numThreads << " threads (" << steals
+         << " stolen), " << totalEncoded << " gates/nodes encoded in total" << endl;
+    return allProven;
+}
+
+// Report how much of the designs went into the solver.
+void printEncodingSummary(ostream& out, bool useStrash, const CnfNetlist& spec, const CnfNetlist& imp,
+                          const AigMiterEncoder& aigMiter) {
+    if (useStrash) {
+        out << "-I- Strash: encoded " << aigMiter.cnf.numEncoded() << " AIG nodes" << endl;
+        return;
+    }
+    out << "-I- Cone of influence: encoded " << spec.numEncoded << " of " << spec.nl.numGates()
+         << " spec gates and " << imp.numEncoded << " of " << imp.nl.numGates() << " impl gates" << endl;
+}
+
+// Write the symbol table of a DIMACS export: the named signals of the
+// miter followed by the difference variable of every checked output.
+bool writeSymbolTable(const string& path, const MiterEncoder& miter, const vector<string>& inputs,
+                      const vector<string>& outputs, const vector<size_t>& checked,
+                      const vector<Var>& diffVars) {
+    ofstream out(path.c_str());
+    if (!out)
+        return false;
+    miter.writeSymbols(out, inputs, outputs);
+    for (size_t k = 0; k < checked.size(); k++)
+        out << diffVars[k] + 1 << " diff:" << outputs[checked[k]] << endl;
+    return true;
+}
+
+// Replace a netlist by its simplified version and report the change.
+void simplifyAndReport(ostream& out, const char* which, Netlist& nl) {
+    CnfSize before = netlistCnfSize(nl);
+    SimplifyStats st;
+    Netlist simple;
+    simplifyNetlist(nl, simple, st);
+    CnfSize after = netlistCnfSize(simple);
+    out << "-I- Simplify " << which << ": gates " << before.gates << " -> " << after.gates << ", variables "
+         << before.vars << " -> " << after.vars << ", clauses " << before.clauses << " -> " << after.clauses
+         << " (" << st.constGates << " constant, " << st.aliasGates << " aliased, " << st.rewritten
+         << " rewritten, " << st.dead << " dead)" << endl;
+    nl = std::move(simple);
+}
+
+// Print the per-output proven/failed/unknown table.
+void printOutputTable(ostream& out, const vector<string>& outputs, const vector<OutputStatus>& results,
+                      const vector<OutputStats>& outStats) {
+    size_t nameWidth = 6;
+    for (const auto& out : outputs)
+        nameWidth = max(nameWidth, out.size());
+    size_t counts[3] = {0, 0, 0};
+    out << "-I- Per-output results:" << endl;
+    out << "  " << left << setw(nameWidth) << "output" << "  status   engine" << endl;
+    for (size_t i = 0; i < outputs.size(); i++) {
+        counts[results[i]]++;
+        out << "  " << left << setw(nameWidth) << outputs[i] << "  " << setw(7) << outputStatusName(results[i])
+            << "  " << outStats[i].engine << endl;
+    }
+    out << right;
+    out << "-I- " << counts[OUT_PROVEN] << " proven, " << counts[OUT_FAILED] << " failed, "
+         << counts[OUT_UNKNOWN] << " unknown" << endl;
+}
+
+//--------------------------------------------------------------------
+// Options of the check of one design pair.
+struct CheckOptions {
+    bool perOutput = false;
+    bool useStrash = false;
+    bool useFraig = false;
+    bool simplify = false;
+    size_t groupSize = 1;
+    int numThreads = 1;
+    int simRounds = 0;
+    string dimacsFile;
+    bool keyPoints = false;
+    vector<KeyPointRule> keyRules;
+    bool sequential = false;
+    ProofCache* cache = NULL;
+    size_t bddSupport = 0;              // --bdd, 0 for off
+    int cubeDepth = 0;                  // --cubes, 0 for off
+    string cexFile;                     // --cex: every failing output, minimized counterexamples
+};
+
+// Verdict, per-output results and statistics of one design pair. The
+// verdict is equivalent, not_equivalent, unknown, port_mismatch or error.
+struct PairReport {
+    string verdict = "unknown";
+    RunStats stats;
+    CheckStats check;
+    vector<string> outputs;
+    vector<OutputStatus> results;
+    vector<InputValues> cexs;           // of the failed outputs
+    vector<OutputStats> outStats;
+    double seconds = 0;
+
+    size_t count(OutputStatus st) const {
+        return std::count(results.begin(), results.end(), st);
+    }
+};
+
+// Write the statistics of a pair as JSON (--stats).
+void writePairStats(PairReport& rep, ostream& out) {
+    for (size_t o = 0; o < rep.outputs.size(); o++)
+        rep.stats.addOutput(rep.outputs[o], outputStatusName(rep.results[o]), rep.outStats[o]);
+    rep.stats.writeJson(out, rep.verdict, rep.check);
+}
+
+// Match the ports of the two flat cells and intern both into netlists.
+// Returns false (verdict port_mismatch) if the ports differ.
+bool internPair(hcmCell* flatSpecCell, hcmCell* flatImpCell, Netlist& specNl, Netlist& impNl, bool& acyclic,
+                vector<string>& inputs, vector<string>& outputs, PairReport& rep, ostream& out) {
+    // --- Extract primary inputs and outputs from both circuits ---
+    vector<string> inputsImp, outputsImp;
+    {
+        ScopedPhase phase(rep.stats, "ports");
+        extractPorts(flatSpecCell, inputs, outputs);
+        extractPorts(flatImpCell, inputsImp, outputsImp);
+
+        sort(inputs.begin(), inputs.end());
+        sort(inputsImp.begin(), inputsImp.end());
+        sort(outputs.begin(), outputs.end());
+        sort(outputsImp.begin(), outputsImp.end());
+    }
+    if (inputs != inputsImp || outputs != outputsImp) {
+        out << "Primary inputs/outputs do not match between spec and implementation! any input would be a counter example" << endl;
+        rep.verdict = "port_mismatch";
+        return false;
+    }
+    // Intern the nets of both designs; from here on the engines work on
+    // net and gate ids and names are only used for reporting.
+    ScopedPhase phase(rep.stats, "netlist");
+    acyclic = buildNetlist(flatSpecCell, specNl);
+    acyclic = buildNetlist(flatImpCell, impNl) && acyclic;
+    return true;
+}
+
+// Key-point pass (-k). The matched internal nets are proven on their
+// local cones, then every open output is checked on its own with the
+// proven pairs as cut points. A counterexample on the cut points need
+// not be one of the designs, so only the proofs are kept: the outputs
+// not proven here go through the normal check, which reports them.
+void checkOnKeyPoints(const CheckOptions& opt, const Netlist& specNl, const MiterPorts& specPorts,
+                      const Netlist& impNl, const MiterPorts& impPorts, const vector<string>& inputs,
+                      const vector<string>& outputs, PairReport& rep, ostream& out) {
+    ScopedPhase phase(rep.stats, "keypoints");
+    vector<KeyPoint> pairs, cuts;
+    KeyPointStats kst;
+    matchKeyPoints(specNl, impNl, opt.keyRules, pairs);
+    proveKeyPoints(specNl, impNl, inputs, pairs, KEYPOINT_CONF_LIMIT, cuts, kst);
+    out << "-I- Key points: " << kst.matched << " matched, " << kst.simDiffer << " differ in simulation, "
+        << kst.proven << " proven, " << kst.notProven << " not proven, " << kst.undecided << " undecided" << endl;
+    vector<size_t> open;
+    for (size_t o = 0; o < outputs.size(); o++)
+        if (rep.results[o] == OUT_UNKNOWN)
+            open.push_back(o);
+    if (cuts.empty() || open.empty())
+        return;
+
+    MiterPorts cutSpecPorts(specPorts), cutImpPorts(impPorts);
+    for (size_t k = 0; k < cuts.size(); k++) {
+        cutSpecPorts.addCut(cuts[k].specNet, inputs.size() + k);
+        cutImpPorts.addCut(cuts[k].impNet, inputs.size() + k);
+    }
+    NetlistMiterEncoder cutMiter(specNl, cutSpecPorts, impNl, cutImpPorts, inputs.size() + cuts.size(),
+                                 outputs.size());
+    vector<OutputStatus> cutResults(rep.results);
+    vector<InputValues> cutCexs(outputs.size());
+    ostringstream unused;
+    if (opt.numThreads > 1) {
+        checkEquivalenceParallel(inputs, outputs, open, cutMiter, 1, opt.numThreads, cutResults, cutCexs,
+                                 rep.outStats, rep.check, unused);
+    } else {
+        CnfSolver solver(preprocessCnf);
+        checkEquivalencePerOutput(solver, inputs, outputs, open, cutMiter, 1, cutResults, cutCexs,
+                                  rep.outStats, rep.check, unused);
+    }
+    size_t numProven = 0;
+    for (size_t o : open) {
+        if (cutResults[o] == OUT_PROVEN) {
+            rep.results[o] = OUT_PROVEN;
+            rep.outStats[o].engine = "keypoint";
+            numProven++;
+        }
+    }
+    out << "-I- Key points: " << numProven << " of " << open.size() << " open outputs proven on "
+        << cuts.size() << " cut points" << endl;
+}
+
+// Proof cache (--cache) of one pair. The key of an output is the pair
+// of structural hashes of its spec and impl nets; a counterexample is
+// stored as the values of the inputs of its two cones in name order (the
+// names are part of the hashes, so the same key has the same inputs).
+struct ConeCache {
+    ProofCache& cache;
+    const Netlist& specNl;
+    const MiterPorts& specPorts;
+    const Netlist& impNl;
+    const MiterPorts& impPorts;
+    const vector<string>& inputs;
+    vector<ProofKey> keys;
+
+    ConeCache(ProofCache& cache, const Netlist& specNl, const MiterPorts& specPorts, const Netlist& impNl,
+              const MiterPorts& impPorts, const vector<string>& inputs)
+        : cache(cache), specNl(specNl), specPorts(specPorts), impNl(impNl), impPorts(impPorts), inputs(inputs) {
+        vector<uint64_t> specHashes, impHashes;
+        netHashes(specNl, specPorts.piIndex, inputs, specHashes);
+        netHashes(impNl, impPorts.piIndex, inputs, impHashes);
+        for (size_t o = 0; o < specPorts.outNets.size(); o++)
+            keys.push_back(ProofKey{specHashes[specPorts.outNets[o]], impHashes[impPorts.outNets[o]]});
+    }
+
+    // Positions of the inputs in the cones of output o, in name order.
+    vector<size_t> coneInputs(size_t o) const {
+        vector<char> inCone(inputs.size(), 0);
+        const Netlist* nls[2] = {&specNl, &impNl};
+        const MiterPorts* ports[2] = {&specPorts, &impPorts};
+        for (int s = 0; s < 2; s++) {
+            const Netlist& nl = *nls[s];
+            vector<int> roots(1, ports[s]->outNets[o]), cone;
+            vector<char> visited(nl.numGates(), 0);
+            collectCone(nl, roots, visited, cone);
+            if (ports[s]->piIndex[roots[0]] >= 0)
+                inCone[ports[s]->piIndex[roots[0]]] = 1;
+            for (int g : cone)
+                for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+                    if (ports[s]->piIndex[nl.fanins[k]] >= 0)
+                        inCone[ports[s]->piIndex[nl.fanins[k]]] = 1;
+        }
+        vector<size_t> res;
+        for (size_t i = 0; i < inputs.size(); i++)
+            if (inCone[i])
+                res.push_back(i);
+        sort(res.begin(), res.end(), [&](size_t a, size_t b) { return inputs[a] < inputs[b]; });
+        return res;
+    }
+
+    bool lookup(size_t o, OutputStatus& st, InputValues& cex) const {
+        bool proven;
+        vector<bool> bits;
+        if (!cache.lookup(keys[o], proven, bits))
+            return false;
+        st = proven ? OUT_PROVEN : OUT_FAILED;
+        if (!proven) {
+            vector<size_t> ins = coneInputs(o);
+            if (ins.size() != bits.size())
+                return false;
+            cex.assign(inputs.size(), -1);
+            for (size_t k = 0; k < ins.size(); k++)
+                cex[ins[k]] = bits[k];
+        }
         return true;
     }
+
+    void store(size_t o, OutputStatus st, const InputValues& cex) {
+        vector<bool> bits;
+        if (st == OUT_FAILED) {
+            if (cex.empty())
+                return;
+            for (size_t i : coneInputs(o))
+                bits.push_back(cex[i] == 1);
+        }
+        cache.store(keys[o], st == OUT_PROVEN, bits);
+    }
+};
+
+// --cex: shrink the counterexample of every failed output to the inputs
+// it needs (minimizeCounterExample, in one incremental solver over the
+// failed cones), confirm each by replaying it through both netlists, and
+// write them to opt.cexFile as simulation vectors: a line naming the
+// primary inputs in order, then per failed output its name and one
+// character per input (0, 1, or x for an input left open).
+void exportCounterExamples(const CheckOptions& opt, const Netlist& specNl, const Netlist& impNl,
+                           const vector<string>& inputs, const vector<string>& outputs, const MiterEncoder& miter,
+                           PairReport& rep, ostream& out) {
+    ScopedPhase phase(rep.stats, "cex");
+    vector<size_t> failed;
+    for (size_t o = 0; o < outputs.size(); o++)
+        if (rep.results[o] == OUT_FAILED && !rep.cexs[o].empty())
+            failed.push_back(o);
+    CnfSolver solver;
+    unique_ptr<MiterEncoder> enc(miter.spawn());
+    enc->encode(solver, failed);
+    vector<SimReplay> replays;
+    vector<size_t> setBefore, setAfter;
+    vector<char> forced;
+    size_t numQueries = 0;
+    for (size_t o : failed) {
+        InputValues& cex = rep.cexs[o];
+        setBefore.push_back(cex.size() - std::count(cex.begin(), cex.end(), -1));
+        Var d = addDiffVar(solver, enc->specLits[o], enc->impLits[o]);
+        forced.push_back(minimizeCounterExample(solver, *enc, d, cex, numQueries));
+        setAfter.push_back(cex.size() - std::count(cex.begin(), cex.end(), -1));
+        SimReplay r;
+        r.inputValues = cex;
+        r.output = o;
+        replays.push_back(r);
+    }
+    replayCounterExamples(specNl, impNl, inputs, outputs, 1, replays);
+
+    size_t nameWidth = 6, numConfirmed = 0;
+    for (size_t o : failed)
+        nameWidth = max(nameWidth, outputs[o].size());
+    out << "-I- Minimized counterexamples (" << numQueries << " queries), replayed on " << SIM_PATTERNS
+        << " patterns each:" << endl;
+    out << "  " << left << setw(nameWidth) << "output" << "  inputs set     exposed" << endl;
+    for (size_t k = 0; k < failed.size(); k++) {
+        ostringstream set, exposed;
+        set << setBefore[k] << " -> " << setAfter[k];
+        exposed << replays[k].exposed << "/" << SIM_PATTERNS;
+        out << "  " << left << setw(nameWidth) << outputs[failed[k]] << "  " << setw(13) << set.str() << "  "
+            << exposed.str();
+        if (!forced[k])
+            out << "  (not minimized: relies on free nets)";
+        out << endl;
+        if (forced[k] && replays[k].exposed == SIM_PATTERNS)
+            numConfirmed++;
+        else if (forced[k])
+            out << "-E- The replay of the counterexample of " << outputs[failed[k]] << " does not expose it" << endl;
+    }
+    out << right;
+    out << "-I- " << numConfirmed << " of " << failed.size() << " counterexamples confirmed by replay" << endl;
+
+    ofstream f(opt.cexFile.c_str());
+    f << "inputs";
+    for (const auto& in : inputs)
+        f << " " << in;
+    f << endl;
+    for (size_t o : failed) {
+        f << outputs[o] << " ";
+        for (signed char v : rep.cexs[o])
+            f << (v < 0 ? 'x' : (char)('0' + v));
+        f << endl;
+    }
+    f.close();
+    if (!f)
+        out << "-E- Could not write " << opt.cexFile << endl;
+    else
+        out << "-I- Wrote " << failed.size() << " counterexamples to " << opt.cexFile << endl;
+}
+
+// Register correspondence (-S): replace the matched flops of both
+// netlists by pseudo ports and add those to the port lists.
+void exposeMatchedRegisters(Netlist& specNl, Netlist& impNl, vector<string>& inputs, vector<string>& outputs,
+                            ostream& out) {
+    RegisterMatch match;
+    matchRegisters(specNl, impNl, inputs, match);
+    vector<int> specFlops, impFlops;
+    vector<string> names;
+    set<string> used;
+    size_t bySignature = 0;
+    for (const auto& p : match.pairs) {
+        specFlops.push_back(p.specGate);
+        impFlops.push_back(p.impGate);
+        string name = p.name;
+        while (!used.insert(name).second)
+            name += "'";
+        names.push_back(name);
+        bySignature += p.bySignature;
+    }
+    out << "-I- Registers: " << match.pairs.size() << " matched (" << match.pairs.size() - bySignature
+        << " by name, " << bySignature << " by simulation signature), " << match.specUnmatched.size()
+        << " spec and " << match.impUnmatched.size() << " impl registers unmatched" << endl;
+    for (int g : match.specUnmatched)
+        out << "-I- Unmatched spec register " << gateName(specNl, g) << endl;
+    for (int g : match.impUnmatched)
+        out << "-I- Unmatched impl register " << gateName(impNl, g) << endl;
+    exposeRegisters(specNl, specFlops, names);
+    exposeRegisters(impNl, impFlops, names);
+    for (const auto& name : names) {
+        inputs.push_back("Q:" + name);
+        outputs.push_back("D:" + name);
+    }
+}
+
+// Check a pair of interned netlists with the given options. Everything
+// is reported on 'out' and the outcome is stored in 'rep'; nothing here
+// touches hcm, so pairs can be checked side by side.
+void checkNetlists(const CheckOptions& opt, Netlist& specNl, Netlist& impNl, bool acyclic,
+                   const vector<string>& primaryInputs, const vector<string>& primaryOutputs, PairReport& rep,
+                   ostream& out) {
+    RunStats& stats = rep.stats;
+    vector<OutputStatus>& results = rep.results;
+    CnfSolver solver(preprocessCnf);
+
+    // The miter ports: the primary ports, with -S also the registers.
+    vector<string> inputsSpec(primaryInputs), outputsSpec(primaryOutputs);
+    // The single miter stops at the first failing output, unless --cex
+    // asks for all of them.
+    bool stopAtFailure = !opt.perOutput && opt.cexFile.empty();
+    if (opt.sequential) {
+        ScopedPhase phase(stats, "registers");
+        exposeMatchedRegisters(specNl, impNl, inputsSpec, outputsSpec, out);
+    }
+
+    if (opt.simplify && !acyclic) {
+        out << "-I- Simplify: skipped, the netlists have a combinational cycle" << endl;
+    } else if (opt.simplify) {
+        ScopedPhase phase(stats, "simplify");
+        simplifyAndReport(out, "spec", specNl);
+        simplifyAndReport(out, "impl", impNl);
+    }
+    CnfSize specSize = netlistCnfSize(specNl), impSize = netlistCnfSize(impNl);
+    stats.addDesign("spec", specSize.gates, specSize.vars, specSize.clauses);
+    stats.addDesign("impl", impSize.gates, impSize.vars, impSize.clauses);
+    MiterPorts specPorts(specNl, inputsSpec, outputsSpec), impPorts(impNl, inputsSpec, outputsSpec);
+
+    rep.outputs = outputsSpec;
+    results.assign(outputsSpec.size(), OUT_UNKNOWN);
+    rep.cexs.assign(outputsSpec.size(), InputValues());
+    rep.outStats.assign(outputsSpec.size(), OutputStats());
+
+    // --- Random simulation: cheap counterexamples before any SAT call ---
+    if (opt.simRounds > 0) {
+        vector<SimMismatch> mismatches;
+        size_t numFailed;
+        {
+            ScopedPhase phase(stats, "sim");
+            numFailed = randomSimulate(specNl, impNl, inputsSpec, outputsSpec, opt.simRounds, 1,
+                                       stopAtFailure, mismatches);
+        }
+        out << "-I- Random simulation (" << opt.simRounds << " x " << SIM_PATTERNS << " patterns): "
+            << numFailed << " failing outputs" << endl;
+        for (const auto& m : mismatches) {
+            out << "\nA counterexample was found by random simulation for output " << outputsSpec[m.outputs[0]]
+                << ":" << endl;
+            printSimCounterExample(out, inputsSpec, m.inputValues);
+            for (size_t k = 0; k < m.outputs.size(); k++) {
+                results[m.outputs[k]] = OUT_FAILED;
+                rep.cexs[m.outputs[k]].assign(m.inputValues.begin(), m.inputValues.end());
+                rep.outStats[m.outputs[k]].engine = "sim";
+                if (k > 0)
+                    out << "The same assignment also exposes output " << outputsSpec[m.outputs[k]] << endl;
+            }
+        }
+        if (numFailed && stopAtFailure) {
+            out << endl << "SATISFIABLE!" << endl;
+            rep.verdict = "not_equivalent";
+            return;
+        }
+    }
+
+    // --- Proof cache: verdicts of cones unchanged since an earlier run ---
+    unique_ptr<ConeCache> coneCache;
+    vector<char> fromCache(outputsSpec.size(), 0);
+    auto storeCache = [&]() {
+        if (coneCache)
+            for (size_t o = 0; o < outputsSpec.size(); o++)
+                if (results[o] != OUT_UNKNOWN && !fromCache[o])
+                    coneCache->store(o, results[o], rep.cexs[o]);
+    };
+    if (opt.cache && acyclic) {
+        ScopedPhase phase(stats, "cache");
+        coneCache.reset(new ConeCache(*opt.cache, specNl, specPorts, impNl, impPorts, inputsSpec));
+        size_t hits[3] = {0, 0, 0}, numOpen = 0;
+        for (size_t o = 0; o < outputsSpec.size(); o++) {
+            if (results[o] != OUT_UNKNOWN)
+                continue;
+            numOpen++;
+            if (!coneCache->lookup(o, results[o], rep.cexs[o]))
+                continue;
+            fromCache[o] = 1;
+            rep.outStats[o].engine = "cache";
+            hits[results[o]]++;
+            if (results[o] == OUT_FAILED) {
+                out << "\nA counterexample was found in the proof cache for output " << outputsSpec[o] << ":"
+                    << endl;
+                printCounterExample(out, inputsSpec, rep.cexs[o]);
+            }
+        }
+        out << "-I- Proof cache: " << hits[OUT_PROVEN] << " proven and " << hits[OUT_FAILED]
+            << " failed outputs known, " << numOpen - hits[OUT_PROVEN] - hits[OUT_FAILED] << " to check" << endl;
+        if (hits[OUT_FAILED] && stopAtFailure) {
+            out << endl << "SATISFIABLE!" << endl;
+            rep.verdict = "not_equivalent";
+            return;
+        }
+    }
+
+    // --- Prepare the miter ---
+    NetlistMiterEncoder netlistMiter(specNl, specPorts, impNl, impPorts, inputsSpec.size(), outputsSpec.size());
+    Aig aig;
+    vector<AigLit> piLits;
+    vector<AigLit> specOuts, impOuts;
+    AigMiterEncoder aigMiter(aig, specOuts, impOuts, piLits, outputsSpec.size());
+    MiterEncoder* miter = &netlistMiter;
+    if (opt.useStrash) {
+        ScopedPhase phase(stats, "strash");
+        for (size_t i = 0; i < inputsSpec.size(); i++)
+            piLits.push_back(aig.createInput());
+        buildAig(aig, specNl, specPorts, piLits, specOuts);
+        unsigned specAnds = aig.numAnds();
+        buildAig(aig, impNl, impPorts, piLits, impOuts);
+        unsigned impAnds = aig.numAnds() - specAnds;
+        if (opt.useFraig) {
+            Aig swept;
+            vector<AigLit> nodeMap;
+            FraigStats st;
+            fraigSweep(aig, swept, nodeMap, FRAIG_CONF_LIMIT, st);
+            for (size_t o = 0; o < outputsSpec.size(); o++) {
+                specOuts[o] = fraigMapLit(nodeMap, specOuts[o]);
+                impOuts[o] = fraigMapLit(nodeMap, impOuts[o]);
+            }
+            for (auto& pi : piLits)
+                pi = fraigMapLit(nodeMap, pi);
+            aig = std::move(swept);
+            out << "-I- Sweep: " << st.satCalls << " SAT calls, " << st.proven << " nodes merged, "
+                << st.disproved << " candidates disproved, " << st.undecided << " undecided; AND nodes "
+                << specAnds + impAnds << " -> " << aig.numAnds() << endl;
+        }
+        size_t merged = 0;
+        for (size_t o = 0; o < outputsSpec.size(); o++) {
+            if (results[o] == OUT_UNKNOWN && specOuts[o] == impOuts[o]) {
+                results[o] = OUT_PROVEN;
+                rep.outStats[o].engine = "strash";
+                merged++;
+            }
+        }
+        miter = &aigMiter;
+        out << "-I- Strash: " << specAnds << " spec AND nodes, impl added " << impAnds
+            << "; " << merged << " of " << outputsSpec.size() << " outputs proven structurally" << endl;
+    }
+
+    // --- Key points: proofs on matched internal nets ---
+    if (opt.keyPoints)
+        checkOnKeyPoints(opt, specNl, specPorts, impNl, impPorts, inputsSpec, outputsSpec, rep, out);
+
+    // --- BDDs for the outputs with a small support ---
+    if (opt.bddSupport) {
+        ScopedPhase phase(stats, "bdd");
+        vector<size_t> open;
+        for (size_t o = 0; o < outputsSpec.size(); o++)
+            if (results[o] == OUT_UNKNOWN)
+                open.push_back(o);
+        BddCheckStats bst;
+        checkOutputsByBdd(specNl, specPorts, impNl, impPorts, inputsSpec.size(), open, opt.bddSupport, results,
+                          rep.cexs, bst);
+        for (size_t o : open) {
+            if (results[o] == OUT_UNKNOWN)
+                continue;
+            rep.outStats[o].engine = "bdd";
+            if (results[o] == OUT_FAILED) {
+                out << "\nA counterexample was found by BDD for output " << outputsSpec[o] << ":" << endl;
+                printCounterExample(out, inputsSpec, rep.cexs[o]);
+            }
+        }
+        out << "-I- BDD: " << bst.proven << " outputs proven, " << bst.failed << " failed; left to SAT: "
+            << bst.tooWide << " with more than " << opt.bddSupport << " support variables, " << bst.tooLarge
+            << " over " << BDD_MAX_NODES << " nodes (peak " << bst.peakNodes << " nodes)" << endl;
+        if (bst.failed && stopAtFailure) {
+            storeCache();
+            out << endl << "SATISFIABLE!" << endl;
+            rep.verdict = "not_equivalent";
+            return;
+        }
+    }
+
+    // --- Perform equivalence check ---
+    vector<size_t> openOutputs;
+    for (size_t o = 0; o < outputsSpec.size(); o++)
+        if (results[o] == OUT_UNKNOWN)
+            openOutputs.push_back(o);
+    // Whatever is decided from here on is decided by SAT.
+    auto labelSat = [&]() {
+        for (size_t o : openOutputs)
+            if (results[o] != OUT_UNKNOWN)
+                rep.outStats[o].engine = "sat";
+    };
+    // Time spent in encoding and solving, also as phases of their own.
+    auto recordCheck = [&](double wall, double cpu) {
+        stats.addPhase("cnf", rep.check.encodeWall, rep.check.encodeCpu);
+        if (rep.check.elimRuns) {
+            stats.addPhase("preprocess", rep.check.elimWall, rep.check.elimCpu);
+            ostringstream secs;
+            secs << fixed << setprecision(3) << rep.check.elimWall << " s (then solving took "
+                 << rep.check.solveWall << " s)";
+            out << "-I- Preprocess: eliminated " << rep.check.elimVars << " variables, clauses "
+                << rep.check.elimClausesBefore << " -> " << rep.check.elimClausesAfter << " in " << secs.str()
+                << endl;
+        }
+        stats.addPhase("solve", rep.check.solveWall, rep.check.solveCpu);
+        stats.addPhase("check", wallClock() - wall, processCpuClock() - cpu);
+        if (!opt.useStrash && opt.numThreads == 1) {
+            stats.setEncodedGates("spec", netlistMiter.spec.numEncoded);
+            stats.setEncodedGates("impl", netlistMiter.imp.numEncoded);
+        }
+    };
+    double checkWall = wallClock(), checkCpu = processCpuClock();
+    if (opt.perOutput) {
+        bool equivalent = true;
+        if (opt.numThreads > 1) {
+            equivalent = checkEquivalenceParallel(inputsSpec, outputsSpec, openOutputs, *miter, opt.groupSize,
+                                                  opt.numThreads, results, rep.cexs, rep.outStats, rep.check, out);
+        } else {
+            equivalent = checkEquivalencePerOutput(solver, inputsSpec, outputsSpec, openOutputs, *miter,
+                                                   opt.groupSize, results, rep.cexs, rep.outStats, rep.check, out);
+            printEncodingSummary(out, opt.useStrash, netlistMiter.spec, netlistMiter.imp, aigMiter);
+        }
+        recordCheck(checkWall, checkCpu);
+        labelSat();
+        bool anyFailed = false;
+        for (size_t o = 0; o < outputsSpec.size(); o++) {
+            if (results[o] != OUT_PROVEN)
+                equivalent = false;
+            if (results[o] == OUT_FAILED)
+                anyFailed = true;
+        }
+        if (runStopped())
+            out << "-I- Run stopped (" << runStopReason() << "); the outputs not checked are UNKNOWN" << endl;
+        if (!opt.cexFile.empty())
+            exportCounterExamples(opt, specNl, impNl, inputsSpec, outputsSpec, *miter, rep, out);
+        storeCache();
+        printOutputTable(out, outputsSpec, results, rep.outStats);
+        out << (equivalent ? "Circuits are equivalent" : "Circuits are NOT proven equivalent") << endl;
+        rep.verdict = equivalent ? "equivalent" : (anyFailed ? "not_equivalent" : "unknown");
+        return;
+    }
+
+    // Build the miter over the cones of all outputs not proven yet. With
+    // -d the clauses are written out as they are added to the solver.
+    DimacsWriter dimacs;
+    if (!opt.dimacsFile.empty()) {
+        if (!dimacs.open(opt.dimacsFile)) {
+            cerr << "-E- Could not create " << opt.dimacsFile << endl;
+            exit(1);
+        }
+        solver.setDimacs(&dimacs);
+    }
+    vector<Var> diffVars;
+    InputValues cex;
+    OutputStatus verdict = opt.cubeDepth
+        ? checkEquivalenceCubes(solver, inputsSpec, openOutputs, *miter, diffVars, opt.cubeDepth, opt.numThreads,
+                                cex, rep.check, out)
+        : checkEquivalence(solver, inputsSpec, openOutputs, *miter, diffVars, cex, rep.check, out);
+    // Per-output verdicts of the single query: all proven, or the outputs
+    // that differ under the counterexample failed.
+    for (size_t k = 0; k < openOutputs.size(); k++) {
+        if (verdict == OUT_PROVEN)
+            results[openOutputs[k]] = OUT_PROVEN;
+        else if (verdict == OUT_FAILED && solver.modelValue(diffVars[k]) == l_True) {
+            results[openOutputs[k]] = OUT_FAILED;
+            rep.cexs[openOutputs[k]] = cex;
+        }
+    }
+    // The DIMACS file gets the miter only, not the clauses of --cex.
+    if (!opt.dimacsFile.empty()) {
+        solver.setDimacs(NULL);
+        dimacs.close(solver.nVars());
+        string symFile = opt.dimacsFile;
+        if (symFile.size() > 3 && symFile.compare(symFile.size() - 3, 3, ".gz") == 0)
+            symFile.resize(symFile.size() - 3);
+        symFile += ".sym";
+        if (!writeSymbolTable(symFile, *miter, inputsSpec, outputsSpec, openOutputs, diffVars)) {
+            cerr << "-E- Could not create " << symFile << endl;
+            exit(1);
+        }
+        out << "-I- DIMACS: wrote " << solver.nVars() << " variables and " << dimacs.clauses() << " clauses to "
+            << opt.dimacsFile << ", symbols to " << symFile << endl;
+    }
+    // With --cex the same solver goes on to the other failing outputs;
+    // those failed before the miter (simulation, cache, BDDs) count too.
+    if (!opt.cexFile.empty()) {
+        if (verdict == OUT_FAILED)
+            enumerateFailures(solver, inputsSpec, outputsSpec, openOutputs, *miter, diffVars, results, rep.cexs,
+                              rep.check, out);
+        if (rep.count(OUT_FAILED))
+            verdict = OUT_FAILED;
+    }
+    recordCheck(checkWall, checkCpu);
+    printEncodingSummary(out, opt.useStrash, netlistMiter.spec, netlistMiter.imp, aigMiter);
+    labelSat();
+    if (!opt.cexFile.empty()) {
+        exportCounterExamples(opt, specNl, impNl, inputsSpec, outputsSpec, *miter, rep, out);
+        printOutputTable(out, outputsSpec, results, rep.outStats);
+    }
+    storeCache();
+
+    if (verdict == OUT_UNKNOWN) {
+        out << "UNKNOWN" << endl;
+        rep.verdict = "unknown";
+        return;
+    }
+    out << (verdict == OUT_PROVEN ? "NOT SATISFIABLE!" : "SATISFIABLE!") << endl;
+    rep.verdict = verdict == OUT_PROVEN ? "equivalent" : "not_equivalent";
+}
+
+//--------------------------------------------------------------------
+// Batch mode: check every pair of a manifest on a pool of numWorkers
+// threads. The hcm work of a pair (parsing through the shared design
+// pool, flattening, interning) is serialized; the checks run side by
+// side. Each pair's log is printed as soon as all earlier pairs are
+// printed, so the output is in manifest order. Ends with one summary
+// line per pair. Returns the reports in manifest order.
+void runBatch(const CheckOptions& opt, const vector<ManifestEntry>& entries, int numWorkers,
+              const set<string>& globalNodes, vector<PairReport>& reports) {
+    DesignPool pool(globalNodes);
+    mutex hcmLock, printLock;
+    size_t n = entries.size();
+    reports.assign(n, PairReport());
+    vector<string> logs(n);
+    vector<char> done(n, 0);
+    size_t nextPrint = 0;
+    double start = wallClock();
+
+    vector<size_t> order(n);
+    for (size_t k = 0; k < n; k++)
+        order[k] = k;
+    runWorkStealing(order, numWorkers, [&](size_t k) {
+        const ManifestEntry& e = entries[k];
+        PairReport& rep = reports[k];
+        rep.stats.setPair(e.specTop, e.implTop);
+        ostringstream log;
+        double pairStart = wallClock();
+        log << "-I- Pair " << k + 1 << " of " << n << ": " << e.specTop << " vs " << e.implTop << endl;
+        if (runStopped()) {
+            log << "-I- Skipped (" << runStopReason() << ")" << endl;
+        } else {
+            Netlist specNl, impNl;
+            bool acyclic = true, interned = false;
+            vector<string> inputs, outputs;
+            {
+                lock_guard<mutex> guard(hcmLock);
+                hcmCell* flatSpec = pool.flatCell(e.specTop, e.specFiles, rep.stats, log);
+                hcmCell* flatImp = flatSpec ? pool.flatCell(e.implTop, e.implFiles, rep.stats, log) : NULL;
+                if (flatSpec && flatImp)
+                    interned = internPair(flatSpec, flatImp, specNl, impNl, acyclic, inputs, outputs, rep, log);
+                else
+                    rep.verdict = "error";
+            }
+            if (interned)
+                checkNetlists(opt, specNl, impNl, acyclic, inputs, outputs, rep, log);
+        }
+        rep.seconds = wallClock() - pairStart;
+        log << endl;
+
+        lock_guard<mutex> guard(printLock);
+        logs[k] = log.str();
+        done[k] = 1;
+        for (; nextPrint < n && done[nextPrint]; nextPrint++) {
+            cout << logs[nextPrint] << flush;
+            logs[nextPrint].clear();
+        }
+    });
+
+    // --- Consolidated report ---
+    size_t specWidth = 4, implWidth = 4;
+    for (const auto& e : entries) {
+        specWidth = max(specWidth, e.specTop.size());
+        implWidth = max(implWidth, e.implTop.size());
+    }
+    map<string, size_t> verdicts;
+    cout << "-I- Batch results:" << endl;
+    cout << "  " << setw(5) << "#" << "  " << left << setw(specWidth) << "spec" << "  " << setw(implWidth)
+         << "impl" << "  " << setw(14) << "verdict" << right << setw(8) << "proven" << setw(8) << "failed"
+         << setw(8) << "unknown" << setw(10) << "seconds" << endl;
+    for (size_t k = 0; k < n; k++) {
+        const PairReport& rep = reports[k];
+        verdicts[rep.verdict]++;
+        cout << "  " << setw(5) << k + 1 << "  " << left << setw(specWidth) << entries[k].specTop << "  "
+             << setw(implWidth) << entries[k].implTop << "  " << setw(14) << rep.verdict << right << setw(8)
+             << rep.count(OUT_PROVEN) << setw(8) << rep.count(OUT_FAILED) << setw(8) << rep.count(OUT_UNKNOWN)
+             << setw(10) << fixed << setprecision(3) << rep.seconds << endl;
+    }
+    cout.unsetf(ios::floatfield);
+    cout << "-I- " << n << " pairs in " << fixed << setprecision(3) << wallClock() - start << " s on "
+         << numWorkers << " workers:";
+    cout.unsetf(ios::floatfield);
+    for (const auto& v : verdicts)
+        cout << " " << v.second << " " << v.first;
+    cout << endl;
+    cout << "-I- Parsed " << pool.numFilesParsed() << " files into " << pool.numDesigns() << " shared designs"
+         << endl;
+    if (runStopped())
+        cout << "-I- Run stopped (" << runStopReason() << "); the pairs not checked are unknown" << endl;
+}
+
+//----------------------------------------------------------------------
+// Front end of a single pair: the spec, then the impl, is parsed and
+// flattened. hcm's parser only reads from a path and is not reentrant,
+// so the two loads cannot overlap.
+
+struct DesignLoad {
+    string top;
+    vector<string> files;
+    hcmCell* flat = NULL;
+    RunStats stats;             // parse and flatten time of this side
+    ostringstream log;          // -I- messages, printed after the load
+    string error;               // -E- message if the load failed
+};
+
+static void loadDesign(hcmDesign* design, DesignLoad& load, set<string> globalNodes) {
+    for (const string& f : load.files) {
+        load.log << "-I- Parsing verilog " << f << " ..." << endl;
+        ScopedPhase phase(load.stats, "parse");
+        if (!design->parseStructuralVerilog(f.c_str())) {
+            load.error = "-E- Could not parse: " + f + " aborting.";
+            return;
+        }
+    }
+    hcmCell* top = design->getCell(load.top);
+    if (!top) {
+        load.error = "-E- could not find cell " + load.top;
+        return;
+    }
+    ScopedPhase phase(load.stats, "flatten");
+    load.flat = hcmFlatten(load.top + string("_flat"), top, globalNodes);
 }
 
 ///////////////////////////////////////////////////////////////////////////
 int main(int argc, char **argv) {
     int argIdx = 1;
     int anyErr = 0;
-    unsigned int i;
     vector<string> specVlgFiles;
     vector<string> implementationVlgFiles;
     string specCellName;
     string implementationCellName;
-    Solver solver;
+    CheckOptions opt;
+    string manifestFile;
+    string statsFile;
+    string cacheFile;
+    Budget runBudget;
+    int retries = -1;
 
-    if (argc < 8) { 
+    if (argc < 3) {
         anyErr++;
     } else {
-        if (!strcmp(argv[argIdx], "-v")) {
+        while (argIdx < argc && argv[argIdx][0] == '-' && strcmp(argv[argIdx], "-s")) {
+            if (!strcmp(argv[argIdx], "-v")) {
+                verbose = true;
+            } else if (!strcmp(argv[argIdx], "-a")) {
+                opt.useStrash = true;
+            } else if (!strcmp(argv[argIdx], "-f")) {
+                opt.useStrash = true;
+                opt.useFraig = true;
+            } else if (!strcmp(argv[argIdx], "-O")) {
+                opt.simplify = true;
+            } else if (!strcmp(argv[argIdx], "-p")) {
+                opt.perOutput = true;
+            } else if (!strcmp(argv[argIdx], "--stats=json")) {
+                statsFile = "-";
+            } else if (!strncmp(argv[argIdx], "--stats=json:", 13) && argv[argIdx][13]) {
+                statsFile = argv[argIdx] + 13;
+            } else if (!strcmp(argv[argIdx], "--budget") && argIdx + 1 < argc) {
+                if (!queryBudget.parse(argv[++argIdx])) {
+                    cerr << "-E- Bad budget " << argv[argIdx] << endl;
+                    anyErr++;
+                }
+            } else if (!strcmp(argv[argIdx], "--run-budget") && argIdx + 1 < argc) {
+                if (!runBudget.parse(argv[++argIdx])) {
+                    cerr << "-E- Bad budget " << argv[argIdx] << endl;
+                    anyErr++;
+                }
+            } else if (!strcmp(argv[argIdx], "--retries") && argIdx + 1 < argc) {
+                retries = max(0, atoi(argv[++argIdx]));
+            } else if (!strcmp(argv[argIdx], "--bdd") && argIdx + 1 < argc) {
+                opt.bddSupport = max(1, atoi(argv[++argIdx]));
+            } else if (!strcmp(argv[argIdx], "--cubes") && argIdx + 1 < argc) {
+                opt.cubeDepth = min(MAX_CUBE_DEPTH, max(1, atoi(argv[++argIdx])));
+            } else if (!strcmp(argv[argIdx], "-e")) {
+                preprocessCnf = true;
+            } else if (!strcmp(argv[argIdx], "-S")) {
+                opt.sequential = true;
+            } else if (!strcmp(argv[argIdx], "-k")) {
+                opt.keyPoints = true;
+            } else if (!strcmp(argv[argIdx], "--keymap") && argIdx + 1 < argc) {
+                opt.keyPoints = true;
+                if (!readKeyPointMap(argv[++argIdx], opt.keyRules, cerr))
+                    anyErr++;
+            } else if (!strcmp(argv[argIdx], "--cache") && argIdx + 1 < argc) {
+                cacheFile = argv[++argIdx];
+            } else if (!strcmp(argv[argIdx], "--cex") && argIdx + 1 < argc) {
+                opt.cexFile = argv[++argIdx];
+            } else if (!strcmp(argv[argIdx], "-d") && argIdx + 1 < argc) {
+                opt.dimacsFile = argv[++argIdx];
+            } else if (!strcmp(argv[argIdx], "-b") && argIdx + 1 < argc) {
+                manifestFile = argv[++argIdx];
+            } else if (!strcmp(argv[argIdx], "-r") && argIdx + 1 < argc) {
+                opt.simRounds = max(0, atoi(argv[++argIdx]));
+            } else if (!strcmp(argv[argIdx], "-g") && argIdx + 1 < argc) {
+                opt.perOutput = true;
+                opt.groupSize = max(1, atoi(argv[++argIdx]));
+            } else if (!strcmp(argv[argIdx], "-j") && argIdx + 1 < argc) {
+                opt.numThreads = max(1, atoi(argv[++argIdx]));
+            } else {
+                cerr << "-E- Unknown option " << argv[argIdx] << endl;
+                anyErr++;
+            }
             argIdx++;
-            verbose = true;
         }
-        if (!strcmp(argv[argIdx], "-s")) {
+        if (!manifestFile.empty()) {
+            if (argIdx < argc) {
+                cerr << "-E- -b takes the pairs from the manifest only" << endl;
+                anyErr++;
+            }
+            if (!opt.dimacsFile.empty()) {
+                cerr << "-E- -d is not supported with -b" << endl;
+                anyErr++;
+            }
+            if (opt.cubeDepth) {
+                cerr << "-E- --cubes is not supported with -b" << endl;
+                anyErr++;
+            }
+            if (!opt.cexFile.empty()) {
+                cerr << "-E- --cex is not supported with -b" << endl;
+                anyErr++;
+            }
+        } else {
+            // -j splits the outputs, or with --cubes the single miter.
+            if (opt.numThreads > 1 && !opt.cubeDepth)
+                opt.perOutput = true;
+            if (argIdx < argc && !strcmp(argv[argIdx], "-s")) {
+                argIdx++;
+                specCellName = argv[argIdx++];
+                while (argIdx < argc && strcmp(argv[argIdx], "-i") != 0) {
+                    specVlgFiles.push_back(argv[argIdx++]);
+                }
+            }
             argIdx++;
-            specCellName = argv[argIdx++];
-            while (strcmp(argv[argIdx], "-i") != 0) {
-                specVlgFiles.push_back(argv[argIdx++]);
+            if (argIdx < argc)
+                implementationCellName = argv[argIdx++];
+            for (; argIdx < argc; argIdx++) {
+                implementationVlgFiles.push_back(argv[argIdx]);
+            }
+            if (implementationVlgFiles.size() < 2 || specVlgFiles.size() < 2) {
+                cerr << "-E- At least top-level and one verilog file are required for each model" << endl;
+                anyErr++;
+            }
+            if (opt.cubeDepth && opt.perOutput) {
+                cerr << "-E- --cubes splits the single miter (not with -p/-g)" << endl;
+                anyErr++;
+            }
+            if (!opt.dimacsFile.empty() && opt.perOutput) {
+                cerr << "-E- -d is only supported in the single-miter mode (not with -p/-g/-j)" << endl;
+                anyErr++;
+            }
+            if (!opt.dimacsFile.empty() && opt.keyPoints) {
+                cerr << "-E- -d is not supported with -k (the miter would hold only the outputs left open)" << endl;
+                anyErr++;
             }
-        }
-        argIdx++;
-        implementationCellName = argv[argIdx++];
-        for (; argIdx < argc; argIdx++) {
-            implementationVlgFiles.push_back(argv[argIdx]);
-        }
-        if (implementationVlgFiles.size() < 2 || specVlgFiles.size() < 2) {
-            cerr << "-E- At least top-level and one verilog file are required for each model" << endl;
-            anyErr++;
         }
     }
     if (anyErr) {
-        cerr << "Usage: " << argv[0] << " [-v] -s top-cell spec_file1.v spec_file2.v -i top-cell impl_file1.v impl_file2.v ... \n";
+        cerr << "Usage: " << argv[0] << " [-v] [-O] [-a] [-f] [-p] [-g group-size] [-j threads] [-r rounds] [-e] [--bdd support] [--cubes depth] [-S] [-k] [--keymap file] [--cache file] [--cex file] [-d file.cnf[.gz]] [--stats=json[:file]] [--budget spec] [--run-budget spec] [--retries N] -s top-cell spec_file1.v spec_file2.v -i top-cell impl_file1.v impl_file2.v ... \n";
+        cerr << "       " << argv[0] << " [options] -b manifest\n";
+        cerr << "  -O     fold constants, collapse buffers/inverters and drop dead logic first\n";
+        cerr << "  -a     merge spec and impl into one structurally hashed AIG before CNF\n";
+        cerr << "  -f     like -a, then SAT-sweep the AIG to merge internal equivalences\n";
+        cerr << "  -p     check every PO pair incrementally and print a per-output table\n";
+        cerr << "  -g N   like -p, but check N PO pairs per solver query\n";
+        cerr << "  -j N   like -p, but check the outputs on N threads (with -b: N pairs at a time)\n";
+        cerr << "  -r N   simulate N x " << SIM_PATTERNS << " random patterns before building the miter\n";
+        cerr << "  -e     eliminate variables of the miter CNF (MiniSat SimpSolver) before solving\n";
+        cerr << "  --bdd N  decide outputs with at most N support variables on BDDs, the rest by SAT\n";
+        cerr << "  --cubes D  split the single miter into 2^D cubes and solve them on the -j threads\n";
+        cerr << "  -S     match registers by name and simulation and check their next-state functions too\n";
+        cerr << "  -k     prove internal nets matched by name first and cut the output cones there\n";
+        cerr << "  --keymap F  like -k, renaming spec nets by the rules of F (lines: spec-regex impl-format)\n";
+        cerr << "  --cache F   reuse the verdicts of unchanged output cones from F and add the new ones\n";
+        cerr << "  --cex F     find every failing output, minimize their counterexamples, replay them and write them to F\n";
+        cerr << "  -d F   also write the miter CNF to F (gzip if F ends in .gz) and its symbols to F.sym\n";
+        cerr << "  -b F   check every pair of manifest F (lines: spec-top files... -i impl-top files...)\n";
+        cerr << "  --stats=json[:F]  write phase times, CNF sizes and solver work as JSON to F (default stdout)\n";
+        cerr << "  --budget conf=N,prop=N,time=S      limits of every solver query (any subset)\n";
+        cerr << "  --run-budget conf=N,prop=N,time=S  limits of the whole run\n";
+        cerr << "  --retries N  retry undecided queries N times, with " << BUDGET_ESCALATION
+             << "x the budget each time (default 2)\n";
         exit(1);
     }
 
-    string fileName = specCellName + ".cnf";
+    // Out-of-budget and interrupted queries leave their outputs UNKNOWN.
+    budgetRetries = retries >= 0 ? retries : 2;
+    installInterruptHandlers();
+    startRunBudget(runBudget);
+
+    // The proof cache is shared by all pairs and written back on exit.
+    ProofCache cache;
+    if (!cacheFile.empty()) {
+        if (!cache.load(cacheFile, cerr))
+            exit(1);
+        opt.cache = &cache;
+        cout << "-I- Proof cache " << cacheFile << ": " << cache.numLoaded() << " entries" << endl;
+    }
+    auto saveCache = [&]() {
+        if (cacheFile.empty() || !cache.numAdded())
+            return;
+        if (cache.save(cacheFile, cerr))
+            cout << "-I- Proof cache: wrote " << cache.numAdded() << " new verdicts to " << cacheFile << endl;
+    };
+
     set<string> globalNodes;
     globalNodes.insert("VDD");
     globalNodes.insert("VSS");
 
-    // spec hcm
-    hcmDesign* specDesign = new hcmDesign("specDesign");
-    for (i = 0; i < specVlgFiles.size(); i++) {
-        printf("-I- Parsing verilog %s ...\n", specVlgFiles[i].c_str());
-        if (!specDesign->parseStructuralVerilog(specVlgFiles[i].c_str())) {
-            cerr << "-E- Could not parse: " << specVlgFiles[i] << " aborting." << endl;
+    // Statistics are collected always and written on exit with --stats.
+    auto openStats = [&](ofstream& file) -> ostream* {
+        if (statsFile == "-")
+            return &cout;
+        file.open(statsFile.c_str());
+        if (!file) {
+            cerr << "-E- Could not create " << statsFile << endl;
+            return NULL;
+        }
+        return &file;
+    };
+
+    // --- Batch mode ---
+    if (!manifestFile.empty()) {
+        vector<ManifestEntry> entries;
+        if (!readManifest(manifestFile, entries, cerr))
             exit(1);
+        // -j sets the number of pairs checked at a time; each pair is
+        // checked on one thread.
+        int numWorkers = opt.numThreads;
+        opt.numThreads = 1;
+        vector<PairReport> reports;
+        runBatch(opt, entries, numWorkers, globalNodes, reports);
+        ofstream file;
+        ostream* out = statsFile.empty() ? NULL : openStats(file);
+        if (out) {
+            *out << "[" << endl;
+            for (size_t k = 0; k < reports.size(); k++) {
+                if (k)
+                    *out << "," << endl;
+                writePairStats(reports[k], *out);
+            }
+            *out << "]" << endl;
         }
-    }
-    hcmCell *topSpecCell = specDesign->getCell(specCellName);
-    if (!topSpecCell) {
-        printf("-E- could not find cell %s\n", specCellName.c_str());
-		exit(1);
+        saveCache();
+        return 0;
     }
 
-    hcmCell *flatSpecCell = hcmFlatten(specCellName + string("_flat"), topSpecCell, globalNodes);
+    PairReport rep;
+    rep.stats.setPair(specCellName, implementationCellName);
+    auto reportStats = [&]() {
+        ofstream file;
+        ostream* out = statsFile.empty() ? NULL : openStats(file);
+        if (out)
+            writePairStats(rep, *out);
+    };
 
-    // implementation hcm
+    // spec and implementation hcm, each with its own copy of the global
+    // nodes
+    DesignLoad specLoad, impLoad;
+    specLoad.top = specCellName;
+    specLoad.files = specVlgFiles;
+    impLoad.top = implementationCellName;
+    impLoad.files = implementationVlgFiles;
+    hcmDesign* specDesign = new hcmDesign("specDesign");
     hcmDesign* impDesign = new hcmDesign("impDesign");
-    for (i = 0; i < implementationVlgFiles.size(); i++) {
-        printf("-I- Parsing verilog %s ...\n", implementationVlgFiles[i].c_str());
-        if (!impDesign->parseStructuralVerilog(implementationVlgFiles[i].c_str())) {
-            printf("-E- could not find cell %s\n", implementationCellName.c_str());
-		    exit(1);
+    for (DesignLoad* load : {&specLoad, &impLoad}) {
+        loadDesign(load == &specLoad ? specDesign : impDesign, *load, globalNodes);
+        rep.stats.addPhases(load->stats);
+        cout << load->log.str();
+        if (!load->error.empty()) {
+            cerr << load->error << endl;
+            exit(1);
         }
     }
-
-    hcmCell *topImpCell = impDesign->getCell(implementationCellName);
-    if (!topImpCell) {
-        cerr << "-E- Could not find cell " << implementationCellName << endl;
-        exit(1);
-    }
-
-    hcmCell *flatImpCell = hcmFlatten(implementationCellName + string("_flat"), topImpCell, globalNodes);
+    hcmCell* flatSpecCell = specLoad.flat;
+    hcmCell* flatImpCell = impLoad.flat;
+    fflush(stdout);
 
   	//---------------------------------------------------------------------------------//
 	//enter your code below
 
-    // --- Extract primary inputs and outputs from both circuits ---
-    vector<string> inputsSpec, outputsSpec, inputsImp, outputsImp;
-    extractPorts(flatSpecCell, inputsSpec, outputsSpec);
-    extractPorts(flatImpCell, inputsImp, outputsImp);
-
-    sort(inputsSpec.begin(), inputsSpec.end());
-    sort(inputsImp.begin(), inputsImp.end());
-    sort(outputsSpec.begin(), outputsSpec.end());
-    sort(outputsImp.begin(), outputsImp.end());
-    if (inputsSpec != inputsImp || outputsSpec != outputsImp) {
-        cout<< "Primary inputs/outputs do not match between spec and implementation! any input would be a counter example" << endl;
+    Netlist specNl, impNl;
+    bool acyclic;
+    vector<string> inputs, outputs;
+    if (!internPair(flatSpecCell, flatImpCell, specNl, impNl, acyclic, inputs, outputs, rep, cout)) {
+        reportStats();
         return 1;
     }
-    // For convenience, create a set of primary inputs.
-    set<string> primaryInputs(inputsSpec.begin(), inputsSpec.end());
-
-    // --- Prepare variable mappings ---
-    map<string, Var> globalInputMap;   // Shared primary inputs.
-    map<string, Var> varMapSpec, varMapImp; // Internal signals for each circuit.
-
-    // Generate CNF for both circuits.
-    generateCNF(flatSpecCell, solver, varMapSpec, primaryInputs, globalInputMap);
-    generateCNF(flatImpCell, solver, varMapImp, primaryInputs, globalInputMap);
-
-    // --- Perform equivalence check ---
-    checkEquivalence(solver, inputsSpec, outputsSpec, outputsImp, varMapSpec, varMapImp);
-
- 	//---------------------------------------------------------------------------------//
-    solver.toDimacs(fileName.c_str());
-    solver.simplify();
-    bool sat = solver.solve();
-    if (sat) {
-        cout << "SATISFIABLE!" << endl;
-    }
-    else {
-        cout << "NOT SATISFIABLE!" << endl;
-    }
+    checkNetlists(opt, specNl, impNl, acyclic, inputs, outputs, rep, cout);
+    saveCache();
+    reportStats();
     return 0;
 }
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include "aig.h"
+
+using namespace std;
+using namespace Minisat;
+
+Aig::Aig() {
+    // Node 0: constant false.
+    nodes.push_back(Node{0, 0});
+}
+
+AigLit Aig::createInput() {
+    unsigned n = nodes.size();
+    nodes.push_back(Node{INPUT_MARK, INPUT_MARK});
+    inputs.push_back(n);
+    return aigMkLit(n);
+}
+
+AigLit Aig::createAnd(AigLit a, AigLit b) {
+    // Trivial cases.
+    if (a == AIG_FALSE || b == AIG_FALSE || a == aigNot(b))
+        return AIG_FALSE;
+    if (a == AIG_TRUE || a == b)
+        return b;
+    if (b == AIG_TRUE)
+        return a;
+    if (a > b)
+        swap(a, b);
+    uint64_t key = ((uint64_t)a << 32) | b;
+    auto it = strash.find(key);
+    if (it != strash.end())
+        return aigMkLit(it->second);
+    unsigned n = nodes.size();
+    nodes.push_back(Node{a, b});
+    strash[key] = n;
+    return aigMkLit(n);
+}
+
+AigLit Aig::createXor(AigLit a, AigLit b) {
+    bool compl_ = aigIsCompl(a) != aigIsCompl(b);
+    a = aigRegular(a);
+    b = aigRegular(b);
+    if (a > b)
+        swap(a, b);
+    // a ^ b = ~(~(a & ~b) & ~(~a & b))
+    AigLit x = aigNot(createAnd(aigNot(createAnd(a, aigNot(b))), aigNot(createAnd(aigNot(a), b))));
+    return aigNotCond(x, compl_);
+}
+
+AigLit Aig::createMux(AigLit s, AigLit t, AigLit e) {
+    return createOr(createAnd(s, t), createAnd(aigNot(s), e));
+}
+
+size_t Aig::coneSize(const vector<AigLit>& roots) const {
+    vector<bool> seen(nodes.size(), false);
+    vector<unsigned> stack;
+    size_t count = 0;
+    for (AigLit r : roots)
+        stack.push_back(aigNode(r));
+    while (!stack.empty()) {
+        unsigned n = stack.back();
+        stack.pop_back();
+        if (seen[n] || !isAnd(n))
+            continue;
+        seen[n] = true;
+        count++;
+        stack.push_back(aigNode(nodes[n].fanin0));
+        stack.push_back(aigNode(nodes[n].fanin1));
+    }
+    return count;
+}
+
+//--------------------------------------------------------------------
+Lit AigCnf::encode(CnfSolver& solver, AigLit a) {
+    if (vars.size() < aig.numNodes())
+        vars.resize(aig.numNodes(), var_Undef);
+    unsigned root = aigNode(a);
+    // Iterative post-order walk over the nodes that have no variable yet.
+    vector<unsigned> stack;
+    if (vars[root] == var_Undef)
+        stack.push_back(root);
+    while (!stack.empty()) {
+        unsigned n = stack.back();
+        if (vars[n] != var_Undef) {
+            stack.pop_back();
+            continue;
+        }
+        if (aig.isConst(n)) {
+            vars[n] = solver.newVar();
+            solver.addClause(~mkLit(vars[n]));
+        } else if (aig.isInput(n)) {
+            vars[n] = solver.newVar();
+        } else {
+            unsigned n0 = aigNode(aig.fanin0(n)), n1 = aigNode(aig.fanin1(n));
+            if (vars[n0] == var_Undef || vars[n1] == var_Undef) {
+                if (vars[n0] == var_Undef)
+                    stack.push_back(n0);
+                if (vars[n1] == var_Undef)
+                    stack.push_back(n1);
+                continue;
+            }
+            // v <-> f0 & f1
+            Var v = solver.newVar();
+            Lit f0 = mkLit(vars[n0], aigIsCompl(aig.fanin0(n)));
+            Lit f1 = mkLit(vars[n1], aigIsCompl(aig.fanin1(n)));
+            solver.addClause(~mkLit(v), f0);
+            solver.addClause(~mkLit(v), f1);
+            solver.addClause(mkLit(v), ~f0, ~f1);
+            vars[n] = v;
+            encoded++;
+        }
+        stack.pop_back();
+    }
+    return mkLit(vars[root], aigIsCompl(a));
+}
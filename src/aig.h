@@ -0,0 +1,84 @@
+#ifndef FEV_AIG_H
+#define FEV_AIG_H
+
+#include <vector>
+#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
+#include "cnfout.h"
+
+//--------------------------------------------------------------------
+// And-inverter graph with structural hashing.
+// A literal is 2*node + complement bit. Node 0 is the constant false, so
+// literal 0 is false and literal 1 is true. Nodes are created in
+// topological order: the fanins of a node always have smaller ids.
+typedef unsigned AigLit;
+
+const AigLit AIG_FALSE = 0;
+const AigLit AIG_TRUE = 1;
+
+inline AigLit aigNot(AigLit a) { return a ^ 1; }
+inline AigLit aigNotCond(AigLit a, bool c) { return a ^ (AigLit)c; }
+inline AigLit aigRegular(AigLit a) { return a & ~1u; }
+inline unsigned aigNode(AigLit a) { return a >> 1; }
+inline bool aigIsCompl(AigLit a) { return a & 1; }
+inline AigLit aigMkLit(unsigned node, bool compl_ = false) { return (node << 1) | (AigLit)compl_; }
+
+class Aig {
+public:
+    Aig();
+
+    // A new free input (PI, flop output or undriven net).
+    AigLit createInput();
+    // a & b, returning an existing node if one with the same fanins exists.
+    AigLit createAnd(AigLit a, AigLit b);
+    AigLit createOr(AigLit a, AigLit b) { return aigNot(createAnd(aigNot(a), aigNot(b))); }
+    // a ^ b, built with complements pulled out so that every xor of the
+    // same two nodes hashes to the same three AND nodes.
+    AigLit createXor(AigLit a, AigLit b);
+    // s ? t : e
+    AigLit createMux(AigLit s, AigLit t, AigLit e);
+
+    unsigned numNodes() const { return nodes.size(); }
+    unsigned numInputs() const { return inputs.size(); }
+    unsigned numAnds() const { return nodes.size() - inputs.size() - 1; }
+    bool isConst(unsigned n) const { return n == 0; }
+    bool isInput(unsigned n) const { return n != 0 && nodes[n].fanin0 == INPUT_MARK; }
+    bool isAnd(unsigned n) const { return n != 0 && nodes[n].fanin0 != INPUT_MARK; }
+    AigLit fanin0(unsigned n) const { return nodes[n].fanin0; }
+    AigLit fanin1(unsigned n) const { return nodes[n].fanin1; }
+    const std::vector<unsigned>& getInputs() const { return inputs; }
+    // Number of AND nodes in the union of the cones of the given literals.
+    size_t coneSize(const std::vector<AigLit>& roots) const;
+
+private:
+    static const AigLit INPUT_MARK = ~0u;
+    struct Node {
+        AigLit fanin0, fanin1;
+    };
+    std::vector<Node> nodes;
+    std::vector<unsigned> inputs;
+    std::unordered_map<uint64_t, unsigned> strash;
+};
+
+//--------------------------------------------------------------------
+// Tseytin encoding of AIG cones into a solver. Only the nodes reached
+// from the literals asked for are encoded, each at most once.
+class AigCnf {
+public:
+    AigCnf(const Aig& aig) : aig(aig) {}
+
+    // Encode the cone of a and return its solver literal.
+    Minisat::Lit encode(CnfSolver& solver, AigLit a);
+    // Solver variable of a node, var_Undef if it was not encoded.
+    Minisat::Var nodeVar(unsigned n) const { return n < vars.size() ? vars[n] : var_Undef; }
+    size_t numEncoded() const { return encoded; }
+    const Aig& getAig() const { return aig; }
+
+private:
+    const Aig& aig;
+    std::vector<Minisat::Var> vars;
+    size_t encoded = 0;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include <fstream>
+#include <sstream>
+#include "batch.h"
+#include "vlgread.h"
+#include "flat.h"
+
+using namespace std;
+
+bool readManifest(const string& path, vector<ManifestEntry>& entries, ostream& err) {
+    ifstream in(path.c_str());
+    if (!in) {
+        err << "-E- Could not open manifest " << path << endl;
+        return false;
+    }
+    bool ok = true;
+    string text;
+    for (int line = 1; getline(in, text); line++) {
+        size_t hash = text.find('#');
+        if (hash != string::npos)
+            text.resize(hash);
+        istringstream words(text);
+        vector<string> w;
+        string word;
+        while (words >> word)
+            w.push_back(word);
+        if (w.empty())
+            continue;
+        ManifestEntry e;
+        e.line = line;
+        size_t k = w[0] == "-s" ? 1 : 0;
+        if (k < w.size())
+            e.specTop = w[k++];
+        for (; k < w.size() && w[k] != "-i"; k++)
+            e.specFiles.push_back(w[k]);
+        if (k + 1 < w.size())
+            e.implTop = w[++k];
+        for (k++; k < w.size(); k++)
+            e.implFiles.push_back(w[k]);
+        if (e.specFiles.empty() || e.implFiles.empty()) {
+            err << "-E- " << path << ":" << line << ": expected spec-top files... -i impl-top files..." << endl;
+            ok = false;
+            continue;
+        }
+        entries.push_back(e);
+    }
+    return ok;
+}
+
+hcmCell* DesignPool::flatCell(const string& top, const vector<string>& files, RunStats& stats, ostream& log) {
+    for (const string& f : files) {
+        if (badFiles.count(f)) {
+            log << "-E- Could not parse: " << f << endl;
+            return NULL;
+        }
+        // Modules of the files, scanned once per file.
+        if (!fileModules.count(f)) {
+            VerilogScan scan;
+            scanVerilog(f, scan);
+            fileModules[f] = scan.modules;
+        }
+    }
+
+    Design* d = NULL;
+    for (auto& cand : designs) {
+        bool fits = true;
+        for (const string& f : files) {
+            if (cand.files.count(f))
+                continue;
+            for (const string& m : fileModules[f])
+                if (cand.modules.count(m))
+                    fits = false;
+        }
+        if (fits) {
+            d = &cand;
+            break;
+        }
+    }
+    if (!d) {
+        designs.push_back(Design());
+        d = &designs.back();
+        d->design = new hcmDesign("batchDesign" + to_string(designs.size()));
+    }
+
+    for (const string& f : files) {
+        if (d->files.count(f))
+            continue;
+        ScopedPhase phase(stats, "parse");
+        log << "-I- Parsing verilog " << f << " ..." << endl;
+        d->files.insert(f);
+        numParsed++;
+        if (!d->design->parseStructuralVerilog(f.c_str())) {
+            badFiles.insert(f);
+            log << "-E- Could not parse: " << f << endl;
+            return NULL;
+        }
+        d->modules.insert(fileModules[f].begin(), fileModules[f].end());
+    }
+
+    auto it = d->flat.find(top);
+    if (it != d->flat.end())
+        return it->second;
+    hcmCell* topCell = d->design->getCell(top);
+    if (!topCell) {
+        log << "-E- Could not find cell " << top << endl;
+        return NULL;
+    }
+    ScopedPhase phase(stats, "flatten");
+    hcmCell* flat = hcmFlatten(top + string("_flat"), topCell, globalNodes);
+    d->flat[top] = flat;
+    return flat;
+}
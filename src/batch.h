@@ -0,0 +1,61 @@
+#ifndef FEV_BATCH_H
+#define FEV_BATCH_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <ostream>
+#include "hcm.h"
+#include "stats.h"
+
+//--------------------------------------------------------------------
+// Batch mode (-b): many design pairs from a manifest in one process.
+
+// One manifest line: "[-s] spec-top spec.v ... -i impl-top impl.v ...".
+struct ManifestEntry {
+    std::string specTop, implTop;
+    std::vector<std::string> specFiles, implFiles;
+    int line;
+};
+
+// Read a manifest; '#' starts a comment. Reports bad lines to 'err'
+// and returns false if there were any.
+bool readManifest(const std::string& path, std::vector<ManifestEntry>& entries, std::ostream& err);
+
+// hcm designs shared by the pairs of a batch. The files of a design
+// side are parsed into the first design that already holds them or that
+// defines none of their modules, so a cell library listed by every pair
+// is parsed once and a spec checked against several impls is parsed and
+// flattened once. A new design is only started when module names clash.
+// Not thread-safe: callers serialize all use of the pool (hcm itself is
+// not reentrant).
+class DesignPool {
+public:
+    DesignPool(const std::set<std::string>& globalNodes) : globalNodes(globalNodes), numParsed(0) {}
+
+    // Flattened top cell 'top' of 'files', NULL (with a message on 'log')
+    // if a file does not parse or the cell does not exist. Parsing and
+    // flattening time goes to 'stats'.
+    hcmCell* flatCell(const std::string& top, const std::vector<std::string>& files, RunStats& stats,
+                      std::ostream& log);
+
+    size_t numDesigns() const { return designs.size(); }
+    size_t numFilesParsed() const { return numParsed; }
+
+private:
+    struct Design {
+        hcmDesign* design;
+        std::set<std::string> files;            // parsed into it
+        std::set<std::string> modules;          // defined by those files
+        std::map<std::string, hcmCell*> flat;   // flattened top cells
+    };
+
+    std::set<std::string> globalNodes;
+    std::vector<Design> designs;
+    std::map<std::string, std::vector<std::string>> fileModules;
+    std::set<std::string> badFiles;                 // failed to parse
+    size_t numParsed;
+};
+
+#endif
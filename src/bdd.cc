@@ -0,0 +1,107 @@
+#include "bdd.h"
+
+using namespace std;
+
+// Initial number of unique table slots (a power of two); the table
+// doubles when it is half full.
+static const size_t BDD_INITIAL_SLOTS = 1 << 12;
+
+static inline size_t hashTriple(uint32_t a, uint32_t b, uint32_t c) {
+    uint64_t h = (uint64_t)a * 0x9e3779b97f4a7c15ULL ^ (uint64_t)b * 0xc2b2ae3d27d4eb4fULL ^
+                 (uint64_t)c * 0x165667b19e3779f9ULL;
+    return h ^ (h >> 29);
+}
+
+BddManager::BddManager(size_t maxNodes) : generation(1), maxNodes(maxNodes) {
+    nodes.push_back(Node{NO_VAR, BDD_FALSE, BDD_FALSE});
+    nodes.push_back(Node{NO_VAR, BDD_TRUE, BDD_TRUE});
+    unique.assign(BDD_INITIAL_SLOTS, 0);
+    computed.assign(BDD_INITIAL_SLOTS, Computed{0, 0, 0, 0, 0});
+}
+
+void BddManager::clear() {
+    // Only the slots of the nodes there are, so that after one large cone
+    // a small one does not pay for the size of the tables.
+    size_t mask = unique.size() - 1;
+    for (BddNode n = 2; n < nodes.size(); n++) {
+        size_t slot = hashTriple(nodes[n].var, nodes[n].lo, nodes[n].hi) & mask;
+        while (unique[slot] != n)
+            slot = (slot + 1) & mask;
+        unique[slot] = 0;
+    }
+    nodes.resize(2);
+    // The computed entries of older generations count as empty.
+    if (++generation == 0) {
+        fill(computed.begin(), computed.end(), Computed{0, 0, 0, 0, 0});
+        generation = 1;
+    }
+}
+
+void BddManager::growUnique() {
+    unique.assign(unique.size() * 2, 0);
+    size_t mask = unique.size() - 1;
+    for (BddNode n = 2; n < nodes.size(); n++) {
+        size_t slot = hashTriple(nodes[n].var, nodes[n].lo, nodes[n].hi) & mask;
+        while (unique[slot])
+            slot = (slot + 1) & mask;
+        unique[slot] = n;
+    }
+    // The computed table follows, so it keeps about one entry per node.
+    computed.assign(unique.size(), Computed{0, 0, 0, 0, 0});
+}
+
+BddNode BddManager::makeNode(unsigned v, BddNode lo, BddNode hi) {
+    if (lo == hi)
+        return lo;
+    size_t mask = unique.size() - 1;
+    size_t slot = hashTriple(v, lo, hi) & mask;
+    for (; unique[slot]; slot = (slot + 1) & mask) {
+        const Node& n = nodes[unique[slot]];
+        if (n.var == v && n.lo == lo && n.hi == hi)
+            return unique[slot];
+    }
+    if (nodes.size() >= maxNodes)
+        return BDD_INVALID;
+    BddNode id = nodes.size();
+    nodes.push_back(Node{v, lo, hi});
+    unique[slot] = id;
+    if (nodes.size() * 2 > unique.size())
+        growUnique();
+    return id;
+}
+
+BddNode BddManager::ite(BddNode f, BddNode g, BddNode h) {
+    if (f == BDD_INVALID || g == BDD_INVALID || h == BDD_INVALID)
+        return BDD_INVALID;
+    if (f == BDD_TRUE || g == h)
+        return g;
+    if (f == BDD_FALSE)
+        return h;
+    if (g == BDD_TRUE && h == BDD_FALSE)
+        return f;
+    Computed& c = computed[hashTriple(f, g, h) & (computed.size() - 1)];
+    if (c.gen == generation && c.f == f && c.g == g && c.h == h)
+        return c.r;
+
+    uint32_t v = min(top(f), min(top(g), top(h)));
+    BddNode lo = ite(cofactor(f, v, false), cofactor(g, v, false), cofactor(h, v, false));
+    BddNode hi = ite(cofactor(f, v, true), cofactor(g, v, true), cofactor(h, v, true));
+    BddNode r = lo == BDD_INVALID || hi == BDD_INVALID ? BDD_INVALID : makeNode(v, lo, hi);
+    if (r != BDD_INVALID) {
+        // makeNode may have resized the table; look the slot up again.
+        Computed& e = computed[hashTriple(f, g, h) & (computed.size() - 1)];
+        e = Computed{f, g, h, r, generation};
+    }
+    return r;
+}
+
+void BddManager::satisfy(BddNode f, vector<signed char>& values) const {
+    while (f != BDD_TRUE) {
+        const Node& n = nodes[f];
+        if (values.size() <= n.var)
+            values.resize(n.var + 1, -1);
+        bool high = n.lo == BDD_FALSE;
+        values[n.var] = high;
+        f = high ? n.hi : n.lo;
+    }
+}
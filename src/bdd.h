@@ -0,0 +1,69 @@
+#ifndef FEV_BDD_H
+#define FEV_BDD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//--------------------------------------------------------------------
+// Reduced ordered BDDs for small output cones (--bdd). Nodes live in
+// one array and are referred to by index: node 0 is the constant false,
+// node 1 true. A unique table (open addressing over node indices) holds
+// every (var, lo, hi) once, so two functions are equal exactly when
+// they are the same node; a direct-mapped computed table caches ITE
+// results. Variable 0 is at the top.
+typedef uint32_t BddNode;
+
+const BddNode BDD_FALSE = 0;
+const BddNode BDD_TRUE = 1;
+// Result of any operation once the node limit is reached.
+const BddNode BDD_INVALID = ~0u;
+
+class BddManager {
+public:
+    // At most maxNodes nodes (terminals included) are created.
+    explicit BddManager(size_t maxNodes);
+
+    BddNode var(unsigned v) { return makeNode(v, BDD_FALSE, BDD_TRUE); }
+    // if f then g else h; every operation below is one ITE.
+    BddNode ite(BddNode f, BddNode g, BddNode h);
+    BddNode bddNot(BddNode f) { return ite(f, BDD_FALSE, BDD_TRUE); }
+    BddNode bddAnd(BddNode f, BddNode g) { return ite(f, g, BDD_FALSE); }
+    BddNode bddOr(BddNode f, BddNode g) { return ite(f, BDD_TRUE, g); }
+    BddNode bddXor(BddNode f, BddNode g) { return ite(f, bddNot(g), g); }
+
+    // One path of f to true: values[v] is 0 or 1 for the variables on
+    // it and -1 for the others. f must not be BDD_FALSE or BDD_INVALID.
+    void satisfy(BddNode f, std::vector<signed char>& values) const;
+
+    size_t numNodes() const { return nodes.size(); }
+    // Drop every node but the terminals. The tables keep their size, but
+    // the cost is that of the nodes dropped, not of the tables.
+    void clear();
+
+private:
+    struct Node {
+        uint32_t var;           // NO_VAR for the terminals
+        BddNode lo, hi;
+    };
+    struct Computed {
+        BddNode f, g, h, r;
+        uint32_t gen;           // valid if it is the current generation
+    };
+    static const uint32_t NO_VAR = ~0u;
+
+    BddNode makeNode(unsigned v, BddNode lo, BddNode hi);
+    void growUnique();
+    uint32_t top(BddNode f) const { return nodes[f].var; }
+    BddNode cofactor(BddNode f, uint32_t v, bool high) const {
+        return nodes[f].var != v ? f : (high ? nodes[f].hi : nodes[f].lo);
+    }
+
+    std::vector<Node> nodes;
+    std::vector<BddNode> unique;        // 0 marks an empty slot
+    std::vector<Computed> computed;
+    uint32_t generation;        // of the computed entries, bumped by clear()
+    size_t maxNodes;
+};
+
+#endif
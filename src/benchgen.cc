@@ -0,0 +1,432 @@
+// Benchmark generator: writes pairs of structural Verilog netlists over
+// the basic cells (buffer, inv, and/or/nand/nor with 2-4 inputs, xor2)
+// for bench.sh. For a width N it writes into a directory:
+//
+//   stdcell.v                      the cell library (empty modules)
+//   add_rca_N.v / add_cla_N.v      ripple-carry vs carry-lookahead adder
+//   add_eco_N.v                    ripple-carry adder with mutated gates
+//   mul_array_N.v / mul_booth_N.v  array vs radix-4 Booth/Wallace multiplier
+//   mul_eco_N.v                    array multiplier with mutated gates
+//   par_chain_N.v / par_tree_N.v   4N-input parity as a chain vs a tree
+//
+// The top module of file x_y_N.v is XY<N> (e.g. AddRca8). Pairs with
+// the same prefix have the same ports and are equivalent, except the
+// ECO copies, which usually are not.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+// Constant nets; the gate helpers fold them away.
+static const string NET_0 = "VSS";
+static const string NET_1 = "VDD";
+
+//--------------------------------------------------------------------
+// A module under construction: its ports, internal nets and gates.
+class Module {
+public:
+    struct Gate {
+        string cell;
+        vector<string> ins;
+        string out;
+    };
+
+    Module(const string& name) : name(name), numNets(0) {}
+
+    void addInputs(const string& prefix, int n) {
+        for (int i = 0; i < n; i++)
+            inputs.push_back(prefix + to_string(i));
+    }
+
+    string newNet() {
+        string n = "n" + to_string(numNets++);
+        wires.push_back(n);
+        return n;
+    }
+
+    string gate(const string& cell, const vector<string>& ins) {
+        string out = newNet();
+        gates.push_back(Gate{cell, ins, out});
+        return out;
+    }
+
+    // Gates with constant folding.
+    string inv(const string& a) {
+        if (a == NET_0)
+            return NET_1;
+        if (a == NET_1)
+            return NET_0;
+        return gate("inv", {a});
+    }
+    string and2(const string& a, const string& b) {
+        if (a == NET_0 || b == NET_0)
+            return NET_0;
+        if (a == NET_1)
+            return b;
+        if (b == NET_1)
+            return a;
+        return gate("and2", {a, b});
+    }
+    string or2(const string& a, const string& b) {
+        if (a == NET_1 || b == NET_1)
+            return NET_1;
+        if (a == NET_0)
+            return b;
+        if (b == NET_0)
+            return a;
+        return gate("or2", {a, b});
+    }
+    string xor2(const string& a, const string& b) {
+        if (a == NET_0)
+            return b;
+        if (b == NET_0)
+            return a;
+        if (a == NET_1)
+            return inv(b);
+        if (b == NET_1)
+            return inv(a);
+        return gate("xor2", {a, b});
+    }
+    // xor2 out of four nand2 cells.
+    string nandXor(const string& a, const string& b) {
+        string t = gate("nand2", {a, b});
+        return gate("nand2", {gate("nand2", {a, t}), gate("nand2", {b, t})});
+    }
+    // and/or of any width as a tree of cells with up to 4 inputs.
+    string wide(const string& op, const vector<string>& terms) {
+        const string& unit = op == "and" ? NET_1 : NET_0;
+        const string& zero = op == "and" ? NET_0 : NET_1;
+        vector<string> ins;
+        for (const string& t : terms) {
+            if (t == zero)
+                return zero;
+            if (t != unit)
+                ins.push_back(t);
+        }
+        while (ins.size() > 1) {
+            vector<string> next;
+            for (size_t i = 0; i < ins.size(); i += 4) {
+                size_t n = min<size_t>(4, ins.size() - i);
+                vector<string> part(ins.begin() + i, ins.begin() + i + n);
+                next.push_back(n == 1 ? part[0] : gate(op + to_string(n), part));
+            }
+            ins = next;
+        }
+        return ins.empty() ? unit : ins[0];
+    }
+
+    // Drive output port 'port' from 'net' through a buffer.
+    void output(const string& port, const string& net) {
+        outputs.push_back(port);
+        gates.push_back(Gate{"buffer", {net}, port});
+    }
+
+    void write(const string& path) const;
+
+    string name;
+    vector<string> inputs, outputs, wires;
+    vector<Gate> gates;
+
+private:
+    int numNets;
+};
+
+static string joinNames(const vector<string>& names) {
+    string s;
+    for (size_t i = 0; i < names.size(); i++)
+        s += (i ? ", " : "") + names[i];
+    return s;
+}
+
+void Module::write(const string& path) const {
+    ofstream out(path.c_str());
+    if (!out) {
+        cerr << "-E- Could not create " << path << endl;
+        exit(1);
+    }
+    vector<string> ports = inputs;
+    ports.insert(ports.end(), outputs.begin(), outputs.end());
+    out << "module " << name << " (" << joinNames(ports) << ");" << endl;
+    out << "input " << joinNames(inputs) << ";" << endl;
+    out << "output " << joinNames(outputs) << ";" << endl;
+    if (!wires.empty())
+        out << "wire " << joinNames(wires) << ";" << endl;
+    static const char* pins = "ABCD";
+    for (size_t g = 0; g < gates.size(); g++) {
+        const Gate& gate = gates[g];
+        out << gate.cell << " g" << g << " (";
+        for (size_t k = 0; k < gate.ins.size(); k++)
+            out << "." << pins[k] << "(" << gate.ins[k] << "), ";
+        out << ".Y(" << gate.out << "));" << endl;
+    }
+    out << "endmodule" << endl;
+}
+
+//--------------------------------------------------------------------
+// Adders: inputs a0.., b0.., outputs s0 .. sN (sN is the carry out).
+
+void fullAdder(Module& m, const string& a, const string& b, const string& c, string& sum, string& carry) {
+    string h = m.xor2(a, b);
+    sum = m.xor2(h, c);
+    carry = m.or2(m.and2(a, b), m.and2(h, c));
+}
+
+// a + b (+ cin) by ripple carry; returns the width+1 sum bits.
+vector<string> rippleAdd(Module& m, const vector<string>& a, const vector<string>& b, string carry = NET_0) {
+    vector<string> sum(a.size());
+    for (size_t i = 0; i < a.size(); i++)
+        fullAdder(m, a[i], b[i], carry, sum[i], carry);
+    sum.push_back(carry);
+    return sum;
+}
+
+// Carry-lookahead in blocks of 4 bits, with the block carries rippling:
+// c[i+1] = g[i] | p[i] g[i-1] | ... | p[i] .. p[j] c[j].
+vector<string> lookaheadAdd(Module& m, const vector<string>& a, const vector<string>& b) {
+    size_t n = a.size();
+    vector<string> g(n), p(n), sum(n);
+    for (size_t i = 0; i < n; i++) {
+        g[i] = m.and2(a[i], b[i]);
+        p[i] = m.xor2(a[i], b[i]);
+    }
+    string blockCarry = NET_0;
+    for (size_t j = 0; j < n; j += 4) {
+        size_t end = min(n, j + 4);
+        vector<string> carry(1, blockCarry);
+        for (size_t i = j; i < end; i++) {
+            vector<string> terms(1, g[i]);
+            vector<string> prod;
+            for (size_t k = i + 1; k-- > j;) {
+                prod.push_back(p[k]);
+                vector<string> term = prod;
+                term.push_back(k > j ? g[k - 1] : blockCarry);
+                terms.push_back(m.wide("and", term));
+            }
+            carry.push_back(m.wide("or", terms));
+        }
+        for (size_t i = j; i < end; i++)
+            sum[i] = m.xor2(p[i], carry[i - j]);
+        blockCarry = carry.back();
+    }
+    sum.push_back(blockCarry);
+    return sum;
+}
+
+Module adder(const string& name, int n, bool lookahead) {
+    Module m(name);
+    m.addInputs("a", n);
+    m.addInputs("b", n);
+    vector<string> a(m.inputs.begin(), m.inputs.begin() + n), b(m.inputs.begin() + n, m.inputs.end());
+    vector<string> sum = lookahead ? lookaheadAdd(m, a, b) : rippleAdd(m, a, b);
+    for (size_t i = 0; i < sum.size(); i++)
+        m.output("s" + to_string(i), sum[i]);
+    return m;
+}
+
+//--------------------------------------------------------------------
+// Unsigned multipliers: inputs a0.., b0.., outputs p0 .. p(2N-1).
+
+// Array multiplier: the partial product rows a & b[i] are added one
+// after the other with ripple-carry adders.
+Module arrayMultiplier(const string& name, int n) {
+    Module m(name);
+    m.addInputs("a", n);
+    m.addInputs("b", n);
+    vector<string> a(m.inputs.begin(), m.inputs.begin() + n), b(m.inputs.begin() + n, m.inputs.end());
+    vector<string> prod, acc;
+    for (int j = 0; j < n; j++)
+        acc.push_back(m.and2(a[j], b[0]));
+    acc.push_back(NET_0);
+    for (int i = 1; i < n; i++) {
+        prod.push_back(acc[0]);
+        vector<string> row, upper(acc.begin() + 1, acc.end());
+        for (int j = 0; j < n; j++)
+            row.push_back(m.and2(a[j], b[i]));
+        acc = rippleAdd(m, upper, row);
+    }
+    prod.insert(prod.end(), acc.begin(), acc.end());
+    prod.resize(2 * n);
+    for (int i = 0; i < 2 * n; i++)
+        m.output("p" + to_string(i), prod[i]);
+    return m;
+}
+
+// Radix-4 Booth multiplier with a Wallace tree. Digit k of b, from the
+// bits (b[2k+1], b[2k], b[2k-1]), is in {-2 .. 2}; its partial product
+// d * a is formed as (|d| a) xor neg, plus neg in the lowest column, and
+// sign-extended to the full 2N columns (the sum is taken mod 2^2N). The
+// columns are then reduced with full and half adders until two rows are
+// left, which a carry-lookahead adder sums.
+Module boothMultiplier(const string& name, int n) {
+    Module m(name);
+    m.addInputs("a", n);
+    m.addInputs("b", n);
+    vector<string> a(m.inputs.begin(), m.inputs.begin() + n), b(m.inputs.begin() + n, m.inputs.end());
+    int width = 2 * n;
+    auto bit = [&](const vector<string>& v, int i) { return i >= 0 && i < (int)v.size() ? v[i] : NET_0; };
+    vector<vector<string>> columns(width);
+    for (int k = 0; 2 * k <= n; k++) {
+        string x2 = bit(b, 2 * k + 1), x1 = bit(b, 2 * k), x0 = bit(b, 2 * k - 1);
+        string one = m.xor2(x1, x0);
+        string two = m.or2(m.wide("and", {x2, m.inv(x1), m.inv(x0)}), m.wide("and", {m.inv(x2), x1, x0}));
+        string neg = x2;
+        for (int j = 0; 2 * k + j < width; j++) {
+            string mag = j <= n ? m.or2(m.and2(one, bit(a, j)), m.and2(two, bit(a, j - 1))) : NET_0;
+            string pp = m.xor2(mag, neg);
+            if (pp != NET_0)
+                columns[2 * k + j].push_back(pp);
+        }
+        if (neg != NET_0)
+            columns[2 * k].push_back(neg);
+    }
+    // Wallace reduction; carries out of the top column are dropped.
+    for (;;) {
+        size_t height = 0;
+        for (const auto& c : columns)
+            height = max(height, c.size());
+        if (height <= 2)
+            break;
+        vector<vector<string>> next(width);
+        for (int c = 0; c < width; c++) {
+            const vector<string>& col = columns[c];
+            size_t i = 0;
+            for (; i + 3 <= col.size(); i += 3) {
+                string sum, carry;
+                fullAdder(m, col[i], col[i + 1], col[i + 2], sum, carry);
+                next[c].push_back(sum);
+                if (c + 1 < width)
+                    next[c + 1].push_back(carry);
+            }
+            if (i + 2 == col.size()) {
+                next[c].push_back(m.xor2(col[i], col[i + 1]));
+                if (c + 1 < width)
+                    next[c + 1].push_back(m.and2(col[i], col[i + 1]));
+            } else if (i + 1 == col.size()) {
+                next[c].push_back(col[i]);
+            }
+        }
+        columns = next;
+    }
+    vector<string> x(width), y(width);
+    for (int c = 0; c < width; c++) {
+        x[c] = bit(columns[c], 0);
+        y[c] = bit(columns[c], 1);
+    }
+    vector<string> prod = lookaheadAdd(m, x, y);
+    for (int i = 0; i < width; i++)
+        m.output("p" + to_string(i), prod[i]);
+    return m;
+}
+
+//--------------------------------------------------------------------
+// Parity of inputs x0 .. x(M-1), output y.
+
+Module parity(const string& name, int numInputs, bool tree) {
+    Module m(name);
+    m.addInputs("x", numInputs);
+    vector<string> level = m.inputs;
+    if (!tree) {
+        string acc = level[0];
+        for (size_t i = 1; i < level.size(); i++)
+            acc = m.xor2(acc, level[i]);
+        m.output("y", acc);
+        return m;
+    }
+    // Balanced tree of nand-based xors.
+    while (level.size() > 1) {
+        vector<string> next;
+        for (size_t i = 0; i + 1 < level.size(); i += 2)
+            next.push_back(m.nandXor(level[i], level[i + 1]));
+        if (level.size() % 2)
+            next.push_back(level.back());
+        level = next;
+    }
+    m.output("y", level[0]);
+    return m;
+}
+
+//--------------------------------------------------------------------
+// ECO copy: replace the cell of 'count' random gates by another one of
+// the same width (and <-> or, nand <-> nor, xor2 -> or2, inv <-> buffer).
+// Output buffers are left alone.
+void mutate(Module& m, int count, mt19937& rng) {
+    size_t numGates = m.gates.size() - m.outputs.size();
+    for (int k = 0; k < count && numGates > 0; k++) {
+        Module::Gate& g = m.gates[rng() % numGates];
+        string width = g.cell.substr(g.cell.find_first_of("0123456789") == string::npos
+                                         ? g.cell.size() : g.cell.find_first_of("0123456789"));
+        string base = g.cell.substr(0, g.cell.size() - width.size());
+        if (base == "and")
+            g.cell = "or" + width;
+        else if (base == "or")
+            g.cell = "and" + width;
+        else if (base == "nand")
+            g.cell = "nor" + width;
+        else if (base == "nor")
+            g.cell = "nand" + width;
+        else if (base == "xor")
+            g.cell = "or" + width;
+        else if (base == "inv")
+            g.cell = "buffer";
+        else if (base == "buffer")
+            g.cell = "inv";
+    }
+}
+
+void writeLibrary(const string& path) {
+    ofstream out(path.c_str());
+    if (!out) {
+        cerr << "-E- Could not create " << path << endl;
+        exit(1);
+    }
+    out << "module buffer (A, Y); input A; output Y; endmodule" << endl;
+    out << "module inv (A, Y); input A; output Y; endmodule" << endl;
+    static const char* families[] = {"and", "or", "nand", "nor"};
+    static const char* pinLists[] = {"A, B", "A, B, C", "A, B, C, D"};
+    for (const char* f : families)
+        for (int n = 2; n <= 4; n++)
+            out << "module " << f << n << " (" << pinLists[n - 2] << ", Y); input " << pinLists[n - 2]
+                << "; output Y; endmodule" << endl;
+    out << "module xor2 (A, B, Y); input A, B; output Y; endmodule" << endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " out-dir width [seed] [mutations]" << endl;
+        cerr << "  writes the adder, multiplier and parity pairs of the given width" << endl;
+        return 1;
+    }
+    string dir = argv[1];
+    int n = atoi(argv[2]);
+    unsigned seed = argc > 3 ? strtoul(argv[3], NULL, 10) : 1;
+    int mutations = argc > 4 ? atoi(argv[4]) : 1;
+    if (n < 2) {
+        cerr << "-E- The width must be at least 2" << endl;
+        return 1;
+    }
+    string w = to_string(n);
+    mt19937 rng(seed);
+
+    writeLibrary(dir + "/stdcell.v");
+    adder("AddRca" + w, n, false).write(dir + "/add_rca_" + w + ".v");
+    adder("AddCla" + w, n, true).write(dir + "/add_cla_" + w + ".v");
+    Module addEco = adder("AddEco" + w, n, false);
+    mutate(addEco, mutations, rng);
+    addEco.write(dir + "/add_eco_" + w + ".v");
+
+    arrayMultiplier("MulArray" + w, n).write(dir + "/mul_array_" + w + ".v");
+    boothMultiplier("MulBooth" + w, n).write(dir + "/mul_booth_" + w + ".v");
+    Module mulEco = arrayMultiplier("MulEco" + w, n);
+    mutate(mulEco, mutations, rng);
+    mulEco.write(dir + "/mul_eco_" + w + ".v");
+
+    parity("ParChain" + w, 4 * n, false).write(dir + "/par_chain_" + w + ".v");
+    parity("ParTree" + w, 4 * n, true).write(dir + "/par_tree_" + w + ".v");
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <thread>
+#include "budget.h"
+#include "stats.h"
+
+using namespace std;
+using namespace Minisat;
+
+// How often the watchdog looks at signals and deadlines.
+static const int WATCHDOG_PERIOD_MS = 5;
+
+bool Budget::parse(const string& spec) {
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == string::npos)
+            end = spec.size();
+        string item = spec.substr(pos, end - pos);
+        size_t eq = item.find('=');
+        if (eq == string::npos)
+            return false;
+        string key = item.substr(0, eq);
+        const char* val = item.c_str() + eq + 1;
+        char* rest;
+        errno = 0;
+        if (key == "conf" || key == "prop") {
+            // Counts: whole non-negative numbers that fit in int64_t.
+            long long n = strtoll(val, &rest, 10);
+            if (rest == val || *rest || errno == ERANGE || n < 0)
+                return false;
+            (key == "conf" ? conflicts : propagations) = n;
+        } else if (key == "time") {
+            double v = strtod(val, &rest);
+            if (rest == val || *rest || !std::isfinite(v) || v < 0)
+                return false;
+            seconds = v;
+        } else {
+            return false;
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+// A count times 'factor', saturated at INT64_MAX.
+static int64_t scaleCount(int64_t n, double factor) {
+    double v = n * factor;
+    return v >= 9.2e18 ? INT64_MAX : (int64_t)v;
+}
+
+Budget Budget::scaled(double factor) const {
+    Budget b = *this;
+    if (b.conflicts >= 0)
+        b.conflicts = scaleCount(b.conflicts, factor);
+    if (b.propagations >= 0)
+        b.propagations = scaleCount(b.propagations, factor);
+    if (b.seconds >= 0)
+        b.seconds *= factor;
+    return b;
+}
+
+string Budget::describe() const {
+    if (!limited())
+        return "unlimited";
+    string s;
+    char buf[64];
+    if (conflicts >= 0) {
+        snprintf(buf, sizeof(buf), "%lld conflicts", (long long)conflicts);
+        s += buf;
+    }
+    if (propagations >= 0) {
+        snprintf(buf, sizeof(buf), "%s%lld propagations", s.empty() ? "" : ", ", (long long)propagations);
+        s += buf;
+    }
+    if (seconds >= 0) {
+        snprintf(buf, sizeof(buf), "%s%g s", s.empty() ? "" : ", ", seconds);
+        s += buf;
+    }
+    return s;
+}
+
+//--------------------------------------------------------------------
+// Run state. The signal handler only sets a flag; the watchdog thread
+// turns the flag and the wall-clock deadlines into Solver::interrupt()
+// calls on the running queries.
+
+namespace {
+
+volatile sig_atomic_t signalCaught = 0;
+atomic<bool> budgetExhausted(false);
+Budget runBudget;
+double runStart = 0;
+atomic<int64_t> runConflicts(0), runPropagations(0);
+
+struct Query {
+    Solver* solver;
+    double deadline;        // wallClock() time, or < 0
+    const atomic<bool>* cancel;
+};
+
+// The watchdog and its query list live until exit (never destroyed, so
+// a query may still end while static objects are torn down).
+struct Watchdog {
+    mutex lock;
+    list<Query> queries;
+    bool running = false;
+
+    list<Query>::iterator add(Solver* solver, double deadline, const atomic<bool>* cancel) {
+        lock_guard<mutex> guard(lock);
+        if (!running) {
+            running = true;
+            thread(&Watchdog::run, this).detach();
+        }
+        return queries.insert(queries.end(), Query{solver, deadline, cancel});
+    }
+
+    void remove(list<Query>::iterator q) {
+        lock_guard<mutex> guard(lock);
+        queries.erase(q);
+    }
+
+    void run() {
+        for (;;) {
+            this_thread::sleep_for(chrono::milliseconds(WATCHDOG_PERIOD_MS));
+            double now = wallClock();
+            if (runBudget.seconds >= 0 && now - runStart >= runBudget.seconds)
+                budgetExhausted = true;
+            bool stop = runStopped();
+            lock_guard<mutex> guard(lock);
+            for (auto& q : queries)
+                if (stop || (q.deadline >= 0 && now >= q.deadline) || (q.cancel && *q.cancel))
+                    q.solver->interrupt();
+        }
+    }
+};
+
+Watchdog& watchdog() {
+    static Watchdog* w = new Watchdog;
+    return *w;
+}
+
+void onSignal(int sig) {
+    signalCaught = 1;
+    signal(sig, SIG_DFL);
+}
+
+}
+
+void installInterruptHandlers() {
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+}
+
+void startRunBudget(const Budget& run) {
+    runBudget = run;
+    runStart = wallClock();
+}
+
+bool runStopped() {
+    return signalCaught || budgetExhausted;
+}
+
+const char* runStopReason() {
+    if (signalCaught)
+        return "interrupted";
+    if (budgetExhausted)
+        return "run budget exhausted";
+    return "";
+}
+
+// The smaller of two limits, where negative means none.
+static int64_t minLimit(int64_t a, int64_t b) {
+    return a < 0 ? b : (b < 0 ? a : min(a, b));
+}
+
+lbool solveWithBudget(SimpSolver& solver, const vec<Lit>& assumps, const Budget& query,
+                      const atomic<bool>* cancel) {
+    if (runStopped() || (cancel && *cancel))
+        return l_Undef;
+    int64_t conf = query.conflicts, prop = query.propagations;
+    if (runBudget.conflicts >= 0)
+        conf = minLimit(conf, max<int64_t>(0, runBudget.conflicts - runConflicts));
+    if (runBudget.propagations >= 0)
+        prop = minLimit(prop, max<int64_t>(0, runBudget.propagations - runPropagations));
+    solver.budgetOff();
+    if (conf >= 0)
+        solver.setConfBudget(conf);
+    if (prop >= 0)
+        solver.setPropBudget(prop);
+
+    // Every query is watched, so that a signal can reach it.
+    double deadline = query.seconds >= 0 ? wallClock() + query.seconds : -1;
+    list<Query>::iterator entry = watchdog().add(&solver, deadline, cancel);
+    solver.clearInterrupt();
+    uint64_t conflicts = solver.conflicts, propagations = solver.propagations;
+    lbool ret = runStopped() || (cancel && *cancel) ? l_Undef : solver.solveLimited(assumps);
+    watchdog().remove(entry);
+    solver.budgetOff();
+    solver.clearInterrupt();
+
+    runConflicts += solver.conflicts - conflicts;
+    runPropagations += solver.propagations - propagations;
+    if ((runBudget.conflicts >= 0 && runConflicts >= runBudget.conflicts) ||
+        (runBudget.propagations >= 0 && runPropagations >= runBudget.propagations))
+        budgetExhausted = true;
+    return ret;
+}
@@ -0,0 +1,53 @@
+#ifndef FEV_BUDGET_H
+#define FEV_BUDGET_H
+
+#include <stdint.h>
+#include <string>
+#include <atomic>
+#include "simp/SimpSolver.h"
+
+//--------------------------------------------------------------------
+// Resource limits of solver queries. Every query runs under the budget
+// of its output(s) and under what is left of the budget of the whole
+// run; SIGINT/SIGTERM stop all queries. A query that hits a limit
+// returns l_Undef, so its outputs stay UNKNOWN and the run can still
+// report everything decided so far.
+
+// Conflict, propagation and wall-clock limits; negative means none.
+struct Budget {
+    int64_t conflicts = -1;
+    int64_t propagations = -1;
+    double seconds = -1;
+
+    // Parse "conf=N,prop=N,time=S" (any subset, in any order): N a whole
+    // number, S a finite number of seconds, all non-negative.
+    bool parse(const std::string& spec);
+    bool limited() const { return conflicts >= 0 || propagations >= 0 || seconds >= 0; }
+    // The budget with every limit multiplied by 'factor'.
+    Budget scaled(double factor) const;
+    std::string describe() const;
+};
+
+// Catch SIGINT and SIGTERM: the first one stops the run, a second one
+// kills the process as usual.
+void installInterruptHandlers();
+
+// Start the budget of the whole run (call before the first query; the
+// clock starts now).
+void startRunBudget(const Budget& run);
+
+// True once a signal was caught or the run budget is used up; no new
+// query is started after that.
+bool runStopped();
+// Why the run stopped ("interrupted", "run budget exhausted"), or "".
+const char* runStopReason();
+
+// solveLimited(assumps) under 'query' and the rest of the run budget.
+// It is SimpSolver's solveLimited, so a solver with eliminated variables
+// (-e) goes through its own solve path and extends the model to them.
+// The query is also interrupted (within a watchdog period) once *cancel
+// becomes true, e.g. when another thread has already found the answer.
+Minisat::lbool solveWithBudget(Minisat::SimpSolver& solver, const Minisat::vec<Minisat::Lit>& assumps,
+                               const Budget& query, const std::atomic<bool>* cancel = NULL);
+
+#endif
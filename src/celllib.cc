@@ -0,0 +1,407 @@
+#include <iostream>
+#include <algorithm>
+#include <ctype.h>
+#include "celllib.h"
+
+using namespace std;
+using namespace Minisat;
+
+//--------------------------------------------------------------------
+// CNF emitters. The and/or family is specialized at compile time for
+// the common widths; every call is picked once per cell, not per gate.
+
+static void emitNone(const CellDef&, CnfSolver&, const Lit*, vec<Lit>&) {
+    // D Flip-Flop: We *Do not add any constraint* so that the sequential
+    // behavior does not mask differences; Q is a free variable. The
+    // outputs of unsupported cells are left free as well.
+}
+
+static void emitBuf(const CellDef&, CnfSolver& solver, const Lit* pins, vec<Lit>&) {
+    // Buffer: Z = A
+    solver.addClause(pins[0], ~pins[1]);
+    solver.addClause(~pins[0], pins[1]);
+}
+
+static void emitInv(const CellDef&, CnfSolver& solver, const Lit* pins, vec<Lit>&) {
+    // NOT: Z = ~A
+    solver.addClause(~pins[0], ~pins[1]);
+    solver.addClause(pins[0], pins[1]);
+}
+
+// AND: Z = A & B & ...; with negIn/negOut this is also NAND (~Z), OR
+// (~Z = ~A & ~B & ...) and NOR (Z = ~A & ~B & ...). N = 0 is any width.
+template <int N, bool negIn, bool negOut>
+static void emitAnd(const CellDef& cell, CnfSolver& solver, const Lit* pins, vec<Lit>& clause) {
+    const int n = N ? N : cell.numInputs;
+    Lit out = pins[n] ^ negOut;
+    clause.clear();
+    clause.push(out);
+    for (int i = 0; i < n; i++) {
+        Lit in = pins[i] ^ negIn;
+        clause.push(~in);
+        solver.addClause(in, ~out);
+    }
+    solver.addClause(clause);
+}
+
+// XOR wider than the truth table limit: a chain of 2-input xors over
+// fresh variables; XNOR negates the last one.
+static void emitWideXor(const CellDef& cell, CnfSolver& solver, const Lit* pins, vec<Lit>&) {
+    Lit acc = pins[0];
+    for (int i = 1; i < cell.numInputs; i++) {
+        Lit b = pins[i];
+        Lit z = i + 1 == cell.numInputs ? pins[cell.numInputs] ^ (cell.type == GATE_XNOR) : mkLit(solver.newVar());
+        solver.addClause(~acc, ~b, ~z);
+        solver.addClause(acc, b, ~z);
+        solver.addClause(acc, ~b, z);
+        solver.addClause(~acc, b, z);
+        acc = z;
+    }
+}
+
+// Any cell with a truth table: one clause per prime implicant.
+static void emitTable(const CellDef& cell, CnfSolver& solver, const Lit* pins, vec<Lit>& clause) {
+    Lit out = pins[cell.numInputs];
+    for (int side = 0; side < 2; side++) {
+        const vector<CellCube>& cubes = side == 0 ? cell.onCubes : cell.offCubes;
+        for (const CellCube& c : cubes) {
+            clause.clear();
+            for (int i = 0; i < cell.numInputs; i++)
+                if (c.care >> i & 1)
+                    clause.push(pins[i] ^ (bool)(c.value >> i & 1));
+            clause.push(side == 0 ? out : ~out);
+            solver.addClause(clause);
+        }
+    }
+}
+
+template <bool negIn, bool negOut>
+static CnfEmitter andEmitter(int numInputs) {
+    switch (numInputs) {
+    case 2: return emitAnd<2, negIn, negOut>;
+    case 3: return emitAnd<3, negIn, negOut>;
+    case 4: return emitAnd<4, negIn, negOut>;
+    default: return emitAnd<0, negIn, negOut>;
+    }
+}
+
+//--------------------------------------------------------------------
+// Compiling a master cell.
+
+uint64_t gateTruth(GateType type, int n) {
+    uint64_t truth = 0;
+    for (unsigned m = 0; m < (1u << n); m++) {
+        int ones = __builtin_popcount(m);
+        bool v = type == GATE_AND || type == GATE_NAND ? ones == n :
+                 type == GATE_OR || type == GATE_NOR ? ones > 0 : ones & 1;
+        bool inv = type == GATE_NAND || type == GATE_NOR || type == GATE_XNOR || type == GATE_INV;
+        if (v != inv)
+            truth |= 1ULL << m;
+    }
+    return truth;
+}
+
+static bool hasPrefix(const string& s, const char* prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+// Decide the function from the (lower case) master name, with the same
+// prefix rules the encoder always used, plus the complex cells.
+static GateType classifyCell(const string& name) {
+    if (hasPrefix(name, "buf"))
+        return GATE_BUF;
+    if (hasPrefix(name, "inv") || name == "not")
+        return GATE_INV;
+    if (hasPrefix(name, "xnor"))
+        return GATE_XNOR;
+    if (hasPrefix(name, "xor"))
+        return GATE_XOR;
+    if (hasPrefix(name, "nor"))
+        return GATE_NOR;
+    if (hasPrefix(name, "nand"))
+        return GATE_NAND;
+    if (hasPrefix(name, "or"))
+        return GATE_OR;
+    if (hasPrefix(name, "and"))
+        return GATE_AND;
+    if (hasPrefix(name, "aoi") || hasPrefix(name, "oai") || hasPrefix(name, "ao") || hasPrefix(name, "oa") ||
+        hasPrefix(name, "mux") || hasPrefix(name, "maj") || hasPrefix(name, "tie") || hasPrefix(name, "logic"))
+        return GATE_TABLE;
+    if (hasPrefix(name, "dff"))
+        return GATE_DFF;
+    return GATE_UNKNOWN;
+}
+
+// Truth table of an and-or-invert style cell: the digits after the
+// prefix are the group sizes, taken from the inputs in pin order
+// (aoi21: Z = ~(A&B | C)). andFirst: and-groups ored (ao/aoi), else
+// or-groups anded (oa/oai). Returns false if the digits do not match
+// the inputs.
+static bool groupTruth(const string& digits, int numInputs, bool andFirst, bool invert, uint64_t& truth) {
+    vector<int> groups;
+    for (char c : digits) {
+        if (!isdigit((unsigned char)c))
+            break;
+        groups.push_back(c - '0');
+    }
+    int total = 0;
+    for (int g : groups)
+        total += g;
+    if (groups.empty() || total != numInputs)
+        return false;
+    truth = 0;
+    for (unsigned m = 0; m < (1u << numInputs); m++) {
+        bool outer = andFirst ? false : true;
+        int pin = 0;
+        for (int g : groups) {
+            bool inner = andFirst ? true : false;
+            for (int k = 0; k < g; k++, pin++) {
+                bool v = m >> pin & 1;
+                inner = andFirst ? inner && v : inner || v;
+            }
+            outer = andFirst ? outer || inner : outer && inner;
+        }
+        if (outer != invert)
+            truth |= 1ULL << m;
+    }
+    return true;
+}
+
+static bool isSelectPin(const string& pin) {
+    string p = pin;
+    for (auto& c : p)
+        c = tolower((unsigned char)c);
+    return p == "s" || p == "s0" || p == "sel";
+}
+
+// Truth table of the cell; false if the function is not known.
+static bool cellTruth(CellDef& cell, const string& name) {
+    int n = cell.numInputs;
+    uint64_t truth = 0;
+    switch (cell.type) {
+    case GATE_BUF:
+    case GATE_INV:
+        if (n != 1)
+            return false;
+        truth = cell.type == GATE_BUF ? 0x2 : 0x1;
+        break;
+    case GATE_AND: case GATE_NAND: case GATE_OR: case GATE_NOR: case GATE_XOR: case GATE_XNOR:
+        truth = gateTruth(cell.type, n);
+        break;
+    case GATE_TABLE:
+        // Tie cells: constant outputs without inputs.
+        if (hasPrefix(name, "tiehi") || name == "tie1" || name == "logic1") {
+            if (n != 0)
+                return false;
+            truth = 1;
+            break;
+        }
+        if (hasPrefix(name, "tielo") || name == "tie0" || name == "logic0") {
+            if (n != 0)
+                return false;
+            break;
+        }
+        if (hasPrefix(name, "aoi"))
+            return groupTruth(name.substr(3), n, true, true, cell.truth);
+        if (hasPrefix(name, "oai"))
+            return groupTruth(name.substr(3), n, false, true, cell.truth);
+        if (hasPrefix(name, "ao"))
+            return groupTruth(name.substr(2), n, true, false, cell.truth);
+        if (hasPrefix(name, "oa"))
+            return groupTruth(name.substr(2), n, false, false, cell.truth);
+        if (hasPrefix(name, "maj")) {
+            if (n % 2 == 0)
+                return false;
+            for (unsigned m = 0; m < (1u << n); m++)
+                if (__builtin_popcount(m) > n / 2)
+                    truth |= 1ULL << m;
+            break;
+        }
+        if (hasPrefix(name, "mux")) {
+            // Z = S ? D1 : D0, the data pins in pin order.
+            if (n != 3)
+                return false;
+            int sel = -1;
+            for (int i = 0; i < n; i++)
+                if (isSelectPin(cell.inputPorts[i]->getName()))
+                    sel = i;
+            if (sel < 0)
+                sel = 2;
+            int d0 = sel == 0 ? 1 : 0, d1 = sel == 2 ? 1 : 2;
+            for (unsigned m = 0; m < 8; m++)
+                if (m >> (m >> sel & 1 ? d1 : d0) & 1)
+                    truth |= 1ULL << m;
+            break;
+        }
+        return false;
+    default:
+        return false;
+    }
+    cell.truth = truth;
+    return true;
+}
+
+// All prime implicants of the minterms in 'set' over n inputs.
+static void primeCubes(uint64_t set, int n, vector<CellCube>& primes) {
+    unsigned full = (1u << n) - 1;
+    auto implies = [&](unsigned care, unsigned value) {
+        for (unsigned m = 0; m <= full; m++)
+            if ((m & care) == value && !(set >> m & 1))
+                return false;
+        return true;
+    };
+    for (unsigned care = 0; care <= full; care++) {
+        // Enumerate the values of the care bits.
+        unsigned value = 0;
+        do {
+            if (implies(care, value)) {
+                bool prime = true;
+                for (int i = 0; i < n && prime; i++)
+                    if (care >> i & 1 && implies(care & ~(1u << i), value & ~(1u << i)))
+                        prime = false;
+                if (prime)
+                    primes.push_back(CellCube{(uint8_t)care, (uint8_t)value});
+            }
+            value = (value - care) & care;
+        } while (value != 0);
+    }
+}
+
+int CellDef::inputPos(const hcmPort* port) const {
+    for (size_t i = 0; i < inputPorts.size(); i++)
+        if (inputPorts[i] == port)
+            return i;
+    return -1;
+}
+
+// Fill in the clause template, the emitter and the CNF size of a cell
+// whose type, width and (if narrow enough) truth table are set.
+static void finishCell(CellDef& cell) {
+    int n = cell.numInputs;
+    if (cell.type != GATE_DFF && cell.type != GATE_UNKNOWN && n <= CELL_MAX_TABLE_INPUTS) {
+        uint64_t all = n == 6 ? ~0ULL : (1ULL << (1 << n)) - 1;
+        primeCubes(cell.truth, n, cell.onCubes);
+        primeCubes(~cell.truth & all, n, cell.offCubes);
+    }
+    cell.numAuxVars = 0;
+    switch (cell.type) {
+    case GATE_BUF:  cell.emit = emitBuf; break;
+    case GATE_INV:  cell.emit = emitInv; break;
+    case GATE_AND:  cell.emit = andEmitter<false, false>(n); break;
+    case GATE_NAND: cell.emit = andEmitter<false, true>(n); break;
+    case GATE_OR:   cell.emit = andEmitter<true, true>(n); break;
+    case GATE_NOR:  cell.emit = andEmitter<true, false>(n); break;
+    case GATE_XOR:
+    case GATE_XNOR:
+        // Up to 4 inputs the 2^n direct clauses beat a chain.
+        cell.emit = n <= 4 ? emitTable : emitWideXor;
+        break;
+    case GATE_TABLE: cell.emit = emitTable; break;
+    default:        cell.emit = emitNone; break;
+    }
+    if (cell.emit == emitBuf || cell.emit == emitInv) {
+        cell.numClauses = 2;
+    } else if (cell.emit == emitTable) {
+        cell.numClauses = cell.onCubes.size() + cell.offCubes.size();
+    } else if (cell.emit == emitWideXor) {
+        cell.numClauses = 4 * (n - 1);
+        cell.numAuxVars = n - 2;
+    } else if (cell.emit == emitNone) {
+        cell.numClauses = 0;
+    } else {
+        cell.numClauses = n + 1;
+    }
+}
+
+int CellLibrary::cellIndex(hcmCell* master) {
+    auto it = index.find(master);
+    if (it != index.end())
+        return it->second;
+
+    CellDef cell;
+    cell.name = master->getName();
+    cell.outPort = NULL;
+    for (hcmPort* port : master->getPorts()) {
+        if (port->getDirection() == IN)
+            cell.inputPorts.push_back(port);
+        else if (port->getDirection() == OUT && !cell.outPort)
+            cell.outPort = port;
+    }
+    cell.numInputs = cell.inputPorts.size();
+    cell.truth = 0;
+    string name = cell.name;
+    for (auto& c : name)
+        c = tolower((unsigned char)c);
+    cell.type = classifyCell(name);
+
+    bool known = cell.type != GATE_UNKNOWN;
+    if (known && cell.type != GATE_DFF) {
+        if (cell.numInputs <= CELL_MAX_TABLE_INPUTS)
+            known = cellTruth(cell, name) && (cell.numInputs > 0 || cell.type == GATE_TABLE);
+        else
+            known = cell.type != GATE_TABLE;
+    }
+    if (!known) {
+        cerr << "-E- Unsupported gate type: " << cell.name << endl;
+        cell.type = GATE_UNKNOWN;
+    }
+    finishCell(cell);
+    cell.dataPin = -1;
+    if (cell.type == GATE_DFF && cell.numInputs == 2) {
+        string pins[2];
+        for (int k = 0; k < 2; k++) {
+            pins[k] = cell.inputPorts[k]->getName();
+            for (auto& c : pins[k])
+                c = tolower((unsigned char)c);
+        }
+        // The D pin by name, or the pin next to a clock (CLK, CK, C, ...).
+        for (int k = 0; k < 2 && cell.dataPin < 0; k++)
+            if (pins[k] == "d")
+                cell.dataPin = k;
+        for (int k = 0; k < 2 && cell.dataPin < 0; k++)
+            if (pins[k][0] == 'c')
+                cell.dataPin = 1 - k;
+    }
+
+    int id = cells.size();
+    cells.push_back(cell);
+    index[master] = id;
+    return id;
+}
+
+int CellLibrary::derivedCell(GateType type, int numInputs, uint64_t truth) {
+    if (numInputs <= CELL_MAX_TABLE_INPUTS) {
+        // Use the family of the function where there is one, so the cell
+        // keeps its dedicated emitter and simulation kernel.
+        type = GATE_TABLE;
+        static const GateType families[] = {GATE_BUF, GATE_INV, GATE_AND, GATE_NAND, GATE_OR, GATE_NOR,
+                                            GATE_XOR, GATE_XNOR};
+        for (GateType f : families) {
+            if ((f == GATE_BUF || f == GATE_INV) != (numInputs == 1) || numInputs == 0)
+                continue;
+            if (gateTruth(f, numInputs) == truth) {
+                type = f;
+                break;
+            }
+        }
+    } else {
+        truth = 0;
+    }
+    auto key = make_pair((int)type * 64 + numInputs, truth);
+    auto it = derived.find(key);
+    if (it != derived.end())
+        return it->second;
+
+    CellDef cell;
+    cell.name = "derived";
+    cell.type = type;
+    cell.numInputs = numInputs;
+    cell.outPort = NULL;
+    cell.truth = truth;
+    cell.dataPin = -1;
+    finishCell(cell);
+    int id = cells.size();
+    cells.push_back(cell);
+    derived[key] = id;
+    return id;
+}
@@ -0,0 +1,92 @@
+#ifndef FEV_CELLLIB_H
+#define FEV_CELLLIB_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <stdint.h>
+#include "hcm.h"
+#include "cnfout.h"
+
+//--------------------------------------------------------------------
+// Cell library. Every master cell of the standard cell library is
+// compiled once, on its first instance, into a CellDef: its function,
+// the order of its input pins, its truth table and a CNF clause
+// template. Engines dispatch on the cell index of a gate instead of
+// testing the master cell name per instance.
+
+// Gate function family. GATE_TABLE cells (mux, aoi/oai, ao/oa, maj) are
+// described by their truth table only; the other families also have
+// dedicated emitters/kernels of any width.
+enum GateType {
+    GATE_BUF, GATE_INV, GATE_AND, GATE_NAND, GATE_OR, GATE_NOR, GATE_XOR, GATE_XNOR,
+    GATE_TABLE, GATE_DFF, GATE_UNKNOWN
+};
+
+// Cells with up to this many inputs get a truth table and a clause
+// template; wider cells must be and/or/nand/nor/xor/xnor.
+const int CELL_MAX_TABLE_INPUTS = 6;
+
+// A product term over the inputs of a cell: input i is in the cube if
+// bit i of 'care' is set, with the polarity in bit i of 'value'.
+struct CellCube {
+    uint8_t care, value;
+};
+
+struct CellDef;
+
+// Adds the clauses of one instance. pins[0 .. numInputs) are the input
+// literals in pin order and pins[numInputs] the output literal; 'clause'
+// is scratch space.
+typedef void (*CnfEmitter)(const CellDef& cell, CnfSolver& solver, const Minisat::Lit* pins,
+                           Minisat::vec<Minisat::Lit>& clause);
+
+struct CellDef {
+    std::string name;
+    GateType type;
+    int numInputs;
+    std::vector<hcmPort*> inputPorts;       // fanin order of the instances
+    hcmPort* outPort;
+    // Output value of every input minterm (bit m: input i = bit i of m),
+    // valid if numInputs <= CELL_MAX_TABLE_INPUTS.
+    uint64_t truth;
+    // All prime implicants of the on-set and the off-set. Each on-set cube
+    // c gives the clause (~c | Z), each off-set cube (~c | ~Z); using all
+    // primes makes unit propagation complete on the cell.
+    std::vector<CellCube> onCubes, offCubes;
+    CnfEmitter emit;
+    int numClauses;                         // clauses and extra variables
+    int numAuxVars;                         // emit() adds per instance
+    // Flops: position of the D input of a plain flop (a clock and D
+    // only), else -1.
+    int dataPin;
+
+    // Position of a master port among the inputs, -1 if it is not one.
+    int inputPos(const hcmPort* port) const;
+};
+
+class CellLibrary {
+public:
+    // Index of the entry of a master cell, compiling it on first use.
+    // Unsupported cells are reported once and get type GATE_UNKNOWN.
+    int cellIndex(hcmCell* master);
+
+    // Index of a cell without a master (made by netlist rewriting): an
+    // and/or/xor family cell for wide ones, else the cell with the given
+    // truth table, using the family type when it matches one.
+    int derivedCell(GateType type, int numInputs, uint64_t truth);
+
+    const CellDef& cell(int i) const { return cells[i]; }
+    size_t numCells() const { return cells.size(); }
+
+private:
+    std::vector<CellDef> cells;
+    std::unordered_map<hcmCell*, int> index;
+    std::map<std::pair<int, uint64_t>, int> derived;
+};
+
+// Truth table of an n-input family cell (n <= CELL_MAX_TABLE_INPUTS).
+uint64_t gateTruth(GateType type, int n);
+
+#endif
@@ -0,0 +1,97 @@
+#include <unistd.h>
+#include "cnfout.h"
+
+using namespace std;
+using namespace Minisat;
+
+// Width of the problem line; it is rewritten in place on close.
+static const int PROBLEM_LINE_WIDTH = 48;
+
+string DimacsWriter::problemLine(int numVars) const {
+    char line[PROBLEM_LINE_WIDTH + 1];
+    snprintf(line, sizeof(line), "p cnf %-20d %-20zu", numVars, numClauses);
+    string s(line);
+    s.resize(PROBLEM_LINE_WIDTH - 1, ' ');
+    return s + "\n";
+}
+
+// A gzip member holding 'data' in one stored (uncompressed) deflate
+// block. Its size depends only on the length of 'data', so the problem
+// line of a compressed file can be patched like that of a plain one;
+// gzip readers decompress consecutive members as one stream.
+static string storedGzipMember(const string& data) {
+    string m("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+    size_t len = data.size();
+    m += (char)0x01;
+    m += (char)(len & 0xff);
+    m += (char)(len >> 8);
+    m += (char)(~len & 0xff);
+    m += (char)((~len >> 8) & 0xff);
+    m += data;
+    uLong crc = crc32(0L, (const Bytef*)data.data(), len);
+    for (int i = 0; i < 4; i++)
+        m += (char)((crc >> (8 * i)) & 0xff);
+    for (int i = 0; i < 4; i++)
+        m += (char)((len >> (8 * i)) & 0xff);
+    return m;
+}
+
+bool DimacsWriter::open(const string& path) {
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    numClauses = 0;
+    bool compress = path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+    if (!compress) {
+        string line = problemLine(0);
+        fwrite(line.data(), 1, line.size(), file);
+        return true;
+    }
+    string member = storedGzipMember(problemLine(0));
+    fwrite(member.data(), 1, member.size(), file);
+    fflush(file);
+    // The clauses follow as a second member, written through zlib on a
+    // duplicate of the descriptor (which shares the file offset).
+    gz = gzdopen(dup(fileno(file)), "wb");
+    return gz != NULL;
+}
+
+void DimacsWriter::write(const char* data, size_t len) {
+    if (gz)
+        gzwrite(gz, data, len);
+    else
+        fwrite(data, 1, len, file);
+}
+
+void DimacsWriter::addClause(const Lit* lits, int n) {
+    if (!file)
+        return;
+    char buf[4096];
+    size_t pos = 0;
+    for (int i = 0; i < n; i++) {
+        if (pos > sizeof(buf) - 16) {
+            write(buf, pos);
+            pos = 0;
+        }
+        pos += snprintf(buf + pos, 16, "%s%d ", sign(lits[i]) ? "-" : "", var(lits[i]) + 1);
+    }
+    buf[pos++] = '0';
+    buf[pos++] = '\n';
+    write(buf, pos);
+    numClauses++;
+}
+
+void DimacsWriter::close(int numVars) {
+    if (!file)
+        return;
+    string line = problemLine(numVars);
+    if (gz) {
+        gzclose(gz);
+        gz = NULL;
+        line = storedGzipMember(line);
+    }
+    fseek(file, 0, SEEK_SET);
+    fwrite(line.data(), 1, line.size(), file);
+    fclose(file);
+    file = NULL;
+}
@@ -0,0 +1,96 @@
+#ifndef FEV_CNFOUT_H
+#define FEV_CNFOUT_H
+
+#include <stdio.h>
+#include <string>
+#include <zlib.h>
+#include "simp/SimpSolver.h"
+
+//--------------------------------------------------------------------
+// DIMACS export. Clauses are streamed to a plain or (for a ".gz" path)
+// gzip-compressed file as they are generated. The problem line is
+// written as a fixed-width placeholder and patched when the file is
+// closed, so the CNF is never held or walked a second time.
+class DimacsWriter {
+public:
+    DimacsWriter() : file(NULL), gz(NULL), numClauses(0) {}
+    ~DimacsWriter() { close(0); }
+
+    // Returns false if the file cannot be created.
+    bool open(const std::string& path);
+    void addClause(const Minisat::Lit* lits, int n);
+    // Patch the problem line and close the file.
+    void close(int numVars);
+    size_t clauses() const { return numClauses; }
+
+private:
+    void write(const char* data, size_t len);
+    std::string problemLine(int numVars) const;
+
+    FILE* file;
+    gzFile gz;
+    size_t numClauses;
+};
+
+// Signed 1-based DIMACS form of a literal.
+inline int dimacsLit(Minisat::Lit p) {
+    return Minisat::sign(p) ? -(Minisat::var(p) + 1) : Minisat::var(p) + 1;
+}
+
+// The solver used for all encodings. It behaves like a MiniSat Solver
+// but can mirror every clause it receives to a DimacsWriter. Built with
+// 'elim', it keeps the occurrence lists of a SimpSolver until
+// eliminateOnce() runs bounded variable elimination (-e); otherwise
+// elimination is turned off at once and it is a plain Solver.
+class CnfSolver : public Minisat::SimpSolver {
+public:
+    explicit CnfSolver(bool elim = false) : dimacs(NULL), elimPending(elim) {
+        if (!elim)
+            eliminate(true);
+    }
+
+    // Mirror the clauses added from now on to 'w' (NULL to stop).
+    void setDimacs(DimacsWriter* w) { dimacs = w; }
+
+    // VSIDS activity of a variable (the branching heuristic's score).
+    double varActivity(Minisat::Var v) const { return activity[v]; }
+
+    // True until eliminateOnce() is called on a solver built with 'elim'.
+    bool canEliminate() const { return elimPending; }
+    // Eliminate the variables that are not frozen, then turn elimination
+    // off: clauses added later may use frozen and new variables only.
+    // Returns false if the clauses are unsatisfiable.
+    bool eliminateOnce() {
+        elimPending = false;
+        return eliminate(true);
+    }
+
+    bool addClause(const Minisat::vec<Minisat::Lit>& ps) {
+        if (dimacs)
+            dimacs->addClause(ps.size() ? &ps[0] : NULL, ps.size());
+        return SimpSolver::addClause(ps);
+    }
+    bool addClause(Minisat::Lit p) {
+        if (dimacs)
+            dimacs->addClause(&p, 1);
+        return SimpSolver::addClause(p);
+    }
+    bool addClause(Minisat::Lit p, Minisat::Lit q) {
+        Minisat::Lit ps[2] = {p, q};
+        if (dimacs)
+            dimacs->addClause(ps, 2);
+        return SimpSolver::addClause(p, q);
+    }
+    bool addClause(Minisat::Lit p, Minisat::Lit q, Minisat::Lit r) {
+        Minisat::Lit ps[3] = {p, q, r};
+        if (dimacs)
+            dimacs->addClause(ps, 3);
+        return SimpSolver::addClause(p, q, r);
+    }
+
+private:
+    DimacsWriter* dimacs;
+    bool elimPending;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include <unordered_map>
+#include "fraig.h"
+#include "sim.h"
+#include "budget.h"
+
+using namespace std;
+using namespace Minisat;
+
+// Number of random 64-bit words simulated before sweeping.
+static const int FRAIG_RANDOM_WORDS = 4;
+
+namespace {
+
+// Simulation signatures of all nodes of an AIG, one column of words per
+// batch of 64 patterns. The random columns come first; the columns after
+// them collect counterexamples.
+class SigTable {
+public:
+    SigTable(const Aig& aig, SimRandom& rnd) : aig(aig) {
+        for (int w = 0; w < FRAIG_RANDOM_WORDS; w++) {
+            columns.push_back(vector<uint64_t>(aig.numNodes(), 0));
+            for (unsigned in : aig.getInputs())
+                columns.back()[in] = rnd.next();
+            simulate(columns.back());
+        }
+    }
+
+    // Add one input pattern (values indexed like aig.getInputs()) and
+    // resimulate its column.
+    void addPattern(const vector<bool>& inputValues) {
+        if (cexBits == 64) {
+            columns.push_back(vector<uint64_t>(aig.numNodes(), 0));
+            cexBits = 0;
+        }
+        vector<uint64_t>& col = columns.back();
+        const vector<unsigned>& inputs = aig.getInputs();
+        for (size_t i = 0; i < inputs.size(); i++)
+            if (inputValues[i])
+                col[inputs[i]] |= 1ULL << cexBits;
+        cexBits++;
+        simulate(col);
+    }
+
+    // Signatures are normalized so that pattern 0 is 0; 'phase' tells
+    // whether the node was complemented for that.
+    bool phase(unsigned n) const { return columns[0][n] & 1; }
+    // Hash of the random columns only, so it does not change when
+    // counterexamples are added; sameClass() compares all columns.
+    uint64_t hash(unsigned n) const {
+        uint64_t mask = phase(n) ? ~0ULL : 0, h = 0x84222325cbf29ce4ULL;
+        for (int w = 0; w < FRAIG_RANDOM_WORDS; w++)
+            h = (h ^ (columns[w][n] ^ mask)) * 0x100000001b3ULL;
+        return h;
+    }
+    bool sameClass(unsigned a, unsigned b) const {
+        uint64_t mask = phase(a) != phase(b) ? ~0ULL : 0;
+        for (const auto& col : columns)
+            if (col[a] != (col[b] ^ mask))
+                return false;
+        return true;
+    }
+
+private:
+    void simulate(vector<uint64_t>& col) {
+        for (unsigned n = 1; n < aig.numNodes(); n++) {
+            if (!aig.isAnd(n))
+                continue;
+            AigLit f0 = aig.fanin0(n), f1 = aig.fanin1(n);
+            uint64_t v0 = col[aigNode(f0)] ^ (aigIsCompl(f0) ? ~0ULL : 0);
+            uint64_t v1 = col[aigNode(f1)] ^ (aigIsCompl(f1) ? ~0ULL : 0);
+            col[n] = v0 & v1;
+        }
+    }
+
+    const Aig& aig;
+    vector<vector<uint64_t>> columns;
+    int cexBits = 64;   // bits used in the last counterexample column
+};
+
+}
+
+void fraigSweep(const Aig& aig, Aig& out, vector<AigLit>& nodeMap,
+                int64_t confLimit, FraigStats& stats) {
+    SimRandom rnd(1);
+    SigTable sigs(aig, rnd);
+    CnfSolver solver;
+    AigCnf cnf(out);
+    nodeMap.assign(aig.numNodes(), AIG_FALSE);
+
+    // Processed nodes that were not merged (class representatives).
+    unordered_multimap<uint64_t, unsigned> reps;
+    reps.insert(make_pair(sigs.hash(0), 0u));
+
+    for (unsigned n = 1; n < aig.numNodes(); n++) {
+        if (aig.isInput(n)) {
+            nodeMap[n] = out.createInput();
+            reps.insert(make_pair(sigs.hash(n), n));
+            continue;
+        }
+        AigLit lit = out.createAnd(fraigMapLit(nodeMap, aig.fanin0(n)), fraigMapLit(nodeMap, aig.fanin1(n)));
+        nodeMap[n] = lit;
+
+        bool merged = false;
+        auto range = reps.equal_range(sigs.hash(n));
+        for (auto it = range.first; it != range.second && !merged && !runStopped(); ++it) {
+            unsigned r = it->second;
+            if (!sigs.sameClass(n, r))
+                continue;
+            // Candidate: n == r, complemented if their phases differ.
+            AigLit target = aigNotCond(nodeMap[r], sigs.phase(n) != sigs.phase(r));
+            if (lit == target) {
+                merged = true;
+                break;
+            }
+            Lit a = cnf.encode(solver, lit), b = cnf.encode(solver, target);
+            Var d = solver.newVar();
+            solver.addClause(~a, b, mkLit(d));
+            solver.addClause(a, ~b, mkLit(d));
+            solver.addClause(a, b, ~mkLit(d));
+            solver.addClause(~a, ~b, ~mkLit(d));
+            vec<Lit> assumps;
+            assumps.push(mkLit(d));
+            Budget budget;
+            budget.conflicts = confLimit;
+            stats.satCalls++;
+            lbool ret = solveWithBudget(solver, assumps, budget);
+            if (ret == l_False) {
+                solver.addClause(~mkLit(d));
+                nodeMap[n] = target;
+                merged = true;
+            } else if (ret == l_True) {
+                // The counterexample separates n from r; it may separate
+                // n from other candidates too, which sameClass() sees.
+                vector<bool> pattern;
+                for (unsigned in : aig.getInputs()) {
+                    Var v = cnf.nodeVar(aigNode(nodeMap[in]));
+                    pattern.push_back(v != var_Undef && solver.modelValue(v) == l_True);
+                }
+                sigs.addPattern(pattern);
+                stats.disproved++;
+            } else {
+                stats.undecided++;
+                break;
+            }
+        }
+        if (merged)
+            stats.proven++;
+        else
+            reps.insert(make_pair(sigs.hash(n), n));
+    }
+
+    // A merged node was built before its check and is dead now: copy
+    // only the cones of the mapped nodes, so that 'out' has live ANDs only.
+    vector<char> live(out.numNodes(), 0);
+    for (AigLit l : nodeMap)
+        live[aigNode(l)] = 1;
+    for (unsigned n = out.numNodes(); n-- > 1;) {
+        if (live[n] && out.isAnd(n))
+            live[aigNode(out.fanin0(n))] = live[aigNode(out.fanin1(n))] = 1;
+    }
+    Aig compact;
+    vector<AigLit> compactMap(out.numNodes(), AIG_FALSE);
+    for (unsigned n = 1; n < out.numNodes(); n++) {
+        if (out.isInput(n))
+            compactMap[n] = compact.createInput();
+        else if (live[n])
+            compactMap[n] = compact.createAnd(fraigMapLit(compactMap, out.fanin0(n)),
+                                              fraigMapLit(compactMap, out.fanin1(n)));
+    }
+    for (AigLit& l : nodeMap)
+        l = fraigMapLit(compactMap, l);
+    out = std::move(compact);
+}
@@ -0,0 +1,40 @@
+#ifndef FEV_FRAIG_H
+#define FEV_FRAIG_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include "aig.h"
+
+//--------------------------------------------------------------------
+// SAT sweeping (fraiging). Nodes of the AIG are grouped by random
+// simulation signature (up to complement); walking the AIG bottom-up,
+// every node is checked against the earlier nodes of its class with a
+// small incremental SAT call. Proven pairs are merged, so the cones of
+// later candidates are built on the merged nodes and their proofs stay
+// local. Every counterexample is added to the simulation patterns and
+// splits the classes it separates.
+
+struct FraigStats {
+    size_t satCalls = 0;
+    size_t proven = 0;       // nodes merged into an earlier node or a constant
+    size_t disproved = 0;    // candidate pairs separated by a counterexample
+    size_t undecided = 0;    // candidate pairs that hit the conflict limit
+};
+
+// Build in 'out' a copy of 'aig' in which proven equivalent nodes are
+// merged; 'out' keeps no node that nothing maps to. nodeMap[n] is the
+// literal of node n of 'aig' in 'out'; the inputs of 'out' are created
+// in the same order as those of 'aig'.
+// Each SAT call is limited to confLimit conflicts and runs under the run
+// budget (solveWithBudget); once the run is stopped, the rest of the AIG
+// is copied without SAT calls.
+void fraigSweep(const Aig& aig, Aig& out, std::vector<AigLit>& nodeMap,
+                int64_t confLimit, FraigStats& stats);
+
+// Literal of 'a' (a literal of the original AIG) in the swept AIG.
+inline AigLit fraigMapLit(const std::vector<AigLit>& nodeMap, AigLit a) {
+    return aigNotCond(nodeMap[aigNode(a)], aigIsCompl(a));
+}
+
+#endif
@@ -0,0 +1,245 @@
+#include <fstream>
+#include <sstream>
+#include "keypoint.h"
+#include "sim.h"
+#include "budget.h"
+
+using namespace std;
+using namespace Minisat;
+
+bool readKeyPointMap(const string& path, vector<KeyPointRule>& rules, ostream& err) {
+    ifstream in(path.c_str());
+    if (!in) {
+        err << "-E- Could not open key point map " << path << endl;
+        return false;
+    }
+    bool ok = true;
+    string text;
+    for (int line = 1; getline(in, text); line++) {
+        size_t hash = text.find('#');
+        if (hash != string::npos)
+            text.resize(hash);
+        istringstream words(text);
+        string pattern, replace, extra;
+        if (!(words >> pattern))
+            continue;
+        if (!(words >> replace) || (words >> extra)) {
+            err << "-E- " << path << ":" << line << ": expected spec-regex impl-format" << endl;
+            ok = false;
+            continue;
+        }
+        KeyPointRule rule;
+        rule.text = pattern + " " + replace;
+        rule.replace = replace;
+        try {
+            rule.pattern.assign(pattern);
+        } catch (const regex_error& e) {
+            err << "-E- " << path << ":" << line << ": bad pattern " << pattern << " (" << e.what() << ")" << endl;
+            ok = false;
+            continue;
+        }
+        rules.push_back(rule);
+    }
+    return ok;
+}
+
+// Net driven by a gate whose output is a function of its fan-in.
+static bool combinational(const Netlist& nl, int net) {
+    int g = nl.driver[net];
+    return g >= 0 && nl.gateTypes[g] != GATE_DFF && nl.gateTypes[g] != GATE_UNKNOWN;
+}
+
+void matchKeyPoints(const Netlist& spec, const Netlist& imp, const vector<KeyPointRule>& rules,
+                    vector<KeyPoint>& pairs) {
+    vector<char> specOut(spec.numNets(), 0), impOut(imp.numNets(), 0);
+    for (int net : spec.outputs)
+        specOut[net] = 1;
+    for (int net : imp.outputs)
+        impOut[net] = 1;
+    vector<char> impUsed(imp.numNets(), 0);
+    smatch m;
+    for (size_t g = 0; g < spec.numGates(); g++) {
+        int net = spec.gateOuts[g];
+        if (specOut[net] || !combinational(spec, net))
+            continue;
+        const string& name = spec.netNames[net];
+        string impName = name;
+        for (const auto& rule : rules) {
+            if (regex_match(name, m, rule.pattern)) {
+                impName = m.format(rule.replace);
+                break;
+            }
+        }
+        int impNet = imp.findNet(impName);
+        if (impNet < 0 || impOut[impNet] || impUsed[impNet] || !combinational(imp, impNet))
+            continue;
+        impUsed[impNet] = 1;
+        pairs.push_back(KeyPoint{net, impNet});
+    }
+}
+
+//--------------------------------------------------------------------
+// Local CNF of one design for one pair: the cone of a net down to the
+// shared sources (primary inputs and cut points), which are one
+// variable in both designs. Only the entries a pair touched are reset.
+
+namespace {
+
+// Variables of the shared sources of the current pair.
+struct SourceVars {
+    vector<Var> vars;
+    vector<int> used;
+
+    void reset() {
+        for (int src : used)
+            vars[src] = var_Undef;
+        used.clear();
+    }
+};
+
+struct LocalCnf {
+    const Netlist& nl;
+    vector<int> sourceIndex;    // net -> shared source, -1 if none
+    vector<Var> netVars;
+    vector<int> touched;
+    vector<pair<int, int>> stack;
+    vec<Lit> pins, clause;
+
+    LocalCnf(const Netlist& nl) : nl(nl), sourceIndex(nl.numNets(), -1), netVars(nl.numNets(), var_Undef) {}
+
+    Var netVar(int net, CnfSolver& solver, SourceVars& sources) {
+        Var& v = netVars[net];
+        if (v != var_Undef)
+            return v;
+        touched.push_back(net);
+        int src = sourceIndex[net];
+        if (src >= 0) {
+            if (sources.vars[src] == var_Undef) {
+                sources.vars[src] = solver.newVar();
+                sources.used.push_back(src);
+            }
+            return v = sources.vars[src];
+        }
+        v = solver.newVar();
+        if (net == nl.vdd)
+            solver.addClause(mkLit(v));
+        else if (net == nl.vss)
+            solver.addClause(~mkLit(v));
+        return v;
+    }
+
+    // A source, or a free net: its driver is not encoded.
+    bool isLeaf(int net) const { return sourceIndex[net] >= 0 || !combinational(nl, net); }
+
+    // Encode the cone of 'root' (post-order DFS) and return its literal.
+    Lit encode(int root, CnfSolver& solver, SourceVars& sources) {
+        if (netVars[root] != var_Undef || isLeaf(root))
+            return mkLit(netVar(root, solver, sources));
+        stack.clear();
+        stack.push_back(make_pair(nl.driver[root], nl.gateFaninBegin(nl.driver[root])));
+        netVar(root, solver, sources);
+        while (!stack.empty()) {
+            pair<int, int>& top = stack.back();
+            int g = top.first;
+            if (top.second < nl.gateFaninEnd(g)) {
+                int in = nl.fanins[top.second++];
+                if (netVars[in] != var_Undef)
+                    continue;
+                netVar(in, solver, sources);
+                if (!isLeaf(in))
+                    stack.push_back(make_pair(nl.driver[in], nl.gateFaninBegin(nl.driver[in])));
+                continue;
+            }
+            const CellDef& cell = nl.lib.cell(nl.gateCells[g]);
+            pins.clear();
+            for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+                pins.push(mkLit(netVars[nl.fanins[k]]));
+            pins.push(mkLit(netVars[nl.gateOuts[g]]));
+            cell.emit(cell, solver, &pins[0], clause);
+            stack.pop_back();
+        }
+        return mkLit(netVars[root]);
+    }
+
+    void reset() {
+        for (int net : touched)
+            netVars[net] = var_Undef;
+        touched.clear();
+    }
+};
+
+}
+
+void proveKeyPoints(const Netlist& spec, const Netlist& imp, const vector<string>& primaryInputs,
+                    const vector<KeyPoint>& pairs, int64_t confLimit, vector<KeyPoint>& proven,
+                    KeyPointStats& stats) {
+    stats.matched += pairs.size();
+    size_t numInputs = primaryInputs.size();
+    LocalCnf specCnf(spec), impCnf(imp);
+    vector<int> specIns, impIns;
+    for (size_t i = 0; i < numInputs; i++) {
+        specIns.push_back(spec.findNet(primaryInputs[i]));
+        impIns.push_back(imp.findNet(primaryInputs[i]));
+        if (specIns[i] >= 0)
+            specCnf.sourceIndex[specIns[i]] = i;
+        if (impIns[i] >= 0)
+            impCnf.sourceIndex[impIns[i]] = i;
+    }
+
+    // One pass of random patterns: pairs whose values differ are not equal.
+    Simulator specSim(spec), impSim(imp);
+    SimRandom rnd(1);
+    randomizeFreeNets(spec, specSim, rnd);
+    randomizeFreeNets(imp, impSim, rnd);
+    for (size_t i = 0; i < numInputs; i++) {
+        for (int w = 0; w < SIM_WORDS; w++) {
+            uint64_t word = rnd.next();
+            if (specIns[i] >= 0)
+                specSim.value(specIns[i])[w] = word;
+            if (impIns[i] >= 0)
+                impSim.value(impIns[i])[w] = word;
+        }
+    }
+    specSim.run();
+    impSim.run();
+
+    Budget budget;
+    budget.conflicts = confLimit;
+    SourceVars sources;
+    sources.vars.assign(numInputs + pairs.size(), var_Undef);
+    for (const KeyPoint& kp : pairs) {
+        if (runStopped())
+            break;
+        const uint64_t* s = specSim.value(kp.specNet);
+        const uint64_t* t = impSim.value(kp.impNet);
+        bool differ = false;
+        for (int w = 0; w < SIM_WORDS; w++)
+            differ = differ || s[w] != t[w];
+        if (differ) {
+            stats.simDiffer++;
+            continue;
+        }
+
+        CnfSolver solver;
+        Lit a = specCnf.encode(kp.specNet, solver, sources);
+        Lit b = impCnf.encode(kp.impNet, solver, sources);
+        specCnf.reset();
+        impCnf.reset();
+        sources.reset();
+        // a XOR b
+        solver.addClause(a, b);
+        solver.addClause(~a, ~b);
+        lbool ret = solveWithBudget(solver, vec<Lit>(), budget);
+        if (ret == l_False) {
+            // From now on both nets are the same free variable.
+            specCnf.sourceIndex[kp.specNet] = numInputs + proven.size();
+            impCnf.sourceIndex[kp.impNet] = numInputs + proven.size();
+            proven.push_back(kp);
+            stats.proven++;
+        } else if (ret == l_True) {
+            stats.notProven++;
+        } else {
+            stats.undecided++;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef FEV_KEYPOINT_H
+#define FEV_KEYPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <regex>
+#include <ostream>
+#include "netlist.h"
+
+//--------------------------------------------------------------------
+// Key points (-k): internal nets of the spec and the impl that belong
+// together by name, directly or through a rename map. The matched pairs
+// are proven in spec topological order, each on its local cones: every
+// pair proven so far is a cut point, i.e. one free variable shared by
+// both designs replaces the two nets and their fan-in. A deep output
+// cone thus becomes a chain of small SAT calls, and the proven pairs
+// cut the output miter the same way.
+
+// One line of a rename map: the impl name of a spec net whose whole
+// name matches 'pattern' is pattern's match formatted with 'replace'
+// ($1, $2, ... as in std::regex_replace).
+struct KeyPointRule {
+    std::string text;           // the line, for messages
+    std::regex pattern;
+    std::string replace;
+};
+
+// Read a rename map: "spec-regex impl-format" per line, '#' starts a
+// comment. The first rule that matches a spec name applies; names no
+// rule matches are looked up unchanged. Reports bad lines to 'err' and
+// returns false if there were any.
+bool readKeyPointMap(const std::string& path, std::vector<KeyPointRule>& rules, std::ostream& err);
+
+struct KeyPoint {
+    int specNet, impNet;
+};
+
+// Match the internal nets of the two netlists: nets driven by a
+// combinational gate in both designs that are not primary outputs.
+// The pairs are in spec topological order.
+void matchKeyPoints(const Netlist& spec, const Netlist& imp, const std::vector<KeyPointRule>& rules,
+                    std::vector<KeyPoint>& pairs);
+
+struct KeyPointStats {
+    size_t matched = 0;
+    size_t simDiffer = 0;       // told apart by random simulation
+    size_t proven = 0;
+    size_t notProven = 0;       // differ on the cut points (maybe only there)
+    size_t undecided = 0;       // hit the conflict limit
+};
+
+// Prove the matched pairs in order, the primary inputs shared by name.
+// Pairs that random simulation tells apart are skipped. 'proven'
+// receives the pairs proven equal (the cut points), in order. Every SAT
+// call is limited to confLimit conflicts.
+void proveKeyPoints(const Netlist& spec, const Netlist& imp, const std::vector<std::string>& primaryInputs,
+                    const std::vector<KeyPoint>& pairs, int64_t confLimit, std::vector<KeyPoint>& proven,
+                    KeyPointStats& stats);
+
+#endif
@@ -0,0 +1,152 @@
+#include <iostream>
+#include "netlist.h"
+
+using namespace std;
+
+int Netlist::netId(const string& name) {
+    auto it = netIds.find(name);
+    if (it != netIds.end())
+        return it->second;
+    int id = netNames.size();
+    netIds[name] = id;
+    netNames.push_back(name);
+    driver.push_back(-1);
+    return id;
+}
+
+int Netlist::findNet(const string& name) const {
+    auto it = netIds.find(name);
+    return it == netIds.end() ? -1 : it->second;
+}
+
+bool buildNetlist(hcmCell* cell, Netlist& nl) {
+    for (auto port : cell->getPorts()) {
+        if (port->getDirection() == IN)
+            nl.inputs.push_back(nl.netId(port->getName()));
+        else if (port->getDirection() == OUT)
+            nl.outputs.push_back(nl.netId(port->getName()));
+    }
+
+    // Collect the gates in instance order first, with their fanins in
+    // one flat array (rawIns[rawStart[g] .. rawStart[g+1])).
+    struct RawGate {
+        int cell;
+        GateType type;
+        int out;
+        hcmInstance* inst;
+    };
+    vector<RawGate> raw;
+    vector<int> rawStart(1, 0), rawIns;
+    for (auto gate : cell->getInstances()) {
+        int cellId = nl.lib.cellIndex(gate.second->masterCell());
+        const CellDef& def = nl.lib.cell(cellId);
+        RawGate g{cellId, def.type, -1, gate.second};
+        // Gates without an output are skipped; tie cells have no inputs.
+        if (!def.outPort)
+            continue;
+        size_t mark = rawIns.size();
+        rawIns.resize(mark + def.numInputs, -1);
+        for (auto instport : gate.second->getInstPorts()) {
+            hcmPort* port = instport.second->getPort();
+            int pos = def.inputPos(port);
+            if (pos >= 0)
+                rawIns[mark + pos] = nl.netId(instport.second->getNode()->getName());
+            else if (port == def.outPort)
+                g.out = nl.netId(instport.second->getNode()->getName());
+        }
+        if (g.out < 0) {
+            rawIns.resize(mark);
+            continue;
+        }
+        // An unconnected input pin reads a net of its own, which is free.
+        for (int k = 0; k < def.numInputs; k++)
+            if (rawIns[mark + k] < 0)
+                rawIns[mark + k] = nl.netId(gate.second->getName() + "/" + def.inputPorts[k]->getName());
+        raw.push_back(g);
+        rawStart.push_back(rawIns.size());
+    }
+    nl.vdd = nl.findNet("VDD");
+    nl.vss = nl.findNet("VSS");
+
+    // Levelize (Kahn). Flop and unsupported gate outputs are free, so
+    // those gates do not wait for their inputs.
+    vector<int> rawDriver(nl.numNets(), -1);
+    for (size_t g = 0; g < raw.size(); g++)
+        rawDriver[raw[g].out] = g;
+    vector<int> pending(raw.size(), 0);
+    vector<vector<int>> readers(nl.numNets());
+    vector<size_t> order;
+    for (size_t g = 0; g < raw.size(); g++) {
+        if (raw[g].type == GATE_DFF || raw[g].type == GATE_UNKNOWN) {
+            order.push_back(g);
+            continue;
+        }
+        for (int k = rawStart[g]; k < rawStart[g + 1]; k++) {
+            int in = rawIns[k];
+            if (rawDriver[in] >= 0) {
+                pending[g]++;
+                readers[in].push_back(g);
+            }
+        }
+        if (pending[g] == 0)
+            order.push_back(g);
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+        for (int r : readers[raw[order[i]].out])
+            if (--pending[r] == 0)
+                order.push_back(r);
+    }
+    bool acyclic = order.size() == raw.size();
+    if (!acyclic) {
+        cerr << "-E- Combinational cycle through " << raw.size() - order.size() << " gates of "
+             << cell->getName() << endl;
+        for (size_t g = 0; g < raw.size(); g++)
+            if (pending[g] > 0)
+                order.push_back(g);
+    }
+
+    nl.faninStart.reserve(raw.size() + 1);
+    nl.fanins.reserve(rawIns.size());
+    nl.faninStart.push_back(0);
+    for (size_t g : order) {
+        nl.driver[raw[g].out] = nl.gateTypes.size();
+        nl.gateCells.push_back(raw[g].cell);
+        nl.gateTypes.push_back(raw[g].type);
+        nl.gateOuts.push_back(raw[g].out);
+        nl.gateInsts.push_back(raw[g].inst);
+        nl.fanins.insert(nl.fanins.end(), rawIns.begin() + rawStart[g], rawIns.begin() + rawStart[g + 1]);
+        nl.faninStart.push_back(nl.fanins.size());
+    }
+    return acyclic;
+}
+
+void collectCone(const Netlist& nl, const vector<int>& roots, vector<char>& visited, vector<int>& cone) {
+    // Flop and unsupported gate outputs are free nets, so the DFS does
+    // not enter their fan-in.
+    auto firstFanin = [&](int g) {
+        GateType t = nl.gateTypes[g];
+        return t == GATE_DFF || t == GATE_UNKNOWN ? nl.gateFaninEnd(g) : nl.gateFaninBegin(g);
+    };
+    // Iterative DFS: (gate, next fanin position to visit).
+    vector<pair<int, int>> stack;
+    for (int root : roots) {
+        int g = nl.driver[root];
+        if (g < 0 || visited[g])
+            continue;
+        visited[g] = 1;
+        stack.push_back(make_pair(g, firstFanin(g)));
+        while (!stack.empty()) {
+            pair<int, int>& top = stack.back();
+            if (top.second == nl.gateFaninEnd(top.first)) {
+                cone.push_back(top.first);
+                stack.pop_back();
+                continue;
+            }
+            int drv = nl.driver[nl.fanins[top.second++]];
+            if (drv < 0 || visited[drv])
+                continue;
+            visited[drv] = 1;
+            stack.push_back(make_pair(drv, firstFanin(drv)));
+        }
+    }
+}
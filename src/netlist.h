@@ -0,0 +1,62 @@
+#ifndef FEV_NETLIST_H
+#define FEV_NETLIST_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "hcm.h"
+#include "celllib.h"
+
+//--------------------------------------------------------------------
+// Flat, levelized copy of a flattened hcmCell. Net names are interned
+// into dense ids once; gates are stored in contiguous arrays in
+// topological order, so engines that walk the whole netlist (e.g. the
+// simulator) work on indices only.
+
+class Netlist {
+public:
+    // Id of a net, interning the name on first use.
+    int netId(const std::string& name);
+    // Id of a net, -1 if there is no such net.
+    int findNet(const std::string& name) const;
+
+    size_t numNets() const { return netNames.size(); }
+    size_t numGates() const { return gateTypes.size(); }
+    int gateFaninBegin(size_t g) const { return faninStart[g]; }
+    int gateFaninEnd(size_t g) const { return faninStart[g + 1]; }
+
+    std::vector<std::string> netNames;   // net id -> name
+    std::vector<int> inputs, outputs;    // PI / PO net ids, in port order
+    std::vector<int> driver;             // net id -> gate index, -1 if undriven
+    int vdd = -1, vss = -1;              // constant nets, -1 if unused
+
+    // Master cells of the gates, compiled once per master.
+    CellLibrary lib;
+
+    // Gates in topological order (flops first: their outputs are sources).
+    // The fanin net ids of gate g are fanins[faninStart[g] .. faninStart[g+1]),
+    // in the pin order of its cell lib.cell(gateCells[g]); gateTypes caches
+    // the cell's type.
+    std::vector<int> gateCells;
+    std::vector<GateType> gateTypes;
+    std::vector<int> gateOuts;
+    std::vector<int> faninStart;
+    std::vector<int> fanins;
+    std::vector<hcmInstance*> gateInsts;
+
+private:
+    std::unordered_map<std::string, int> netIds;
+};
+
+// Build the netlist of a flattened cell. Returns false (and reports the
+// gates involved) if the combinational logic has a cycle.
+bool buildNetlist(hcmCell* cell, Netlist& nl);
+
+// Append to 'cone' the gates in the transitive fan-in of the root nets,
+// drivers before readers. Gates already marked in 'visited' (one flag
+// per gate) are skipped and every gate added is marked, so calling this
+// repeatedly with the same flags returns only the gates that are new.
+void collectCone(const Netlist& nl, const std::vector<int>& roots,
+                 std::vector<char>& visited, std::vector<int>& cone);
+
+#endif
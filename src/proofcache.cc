@@ -0,0 +1,194 @@
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
+#include "proofcache.h"
+
+using namespace std;
+
+static const char CACHE_MAGIC[8] = {'F', 'E', 'V', 'P', 'R', 'F', '1', '\n'};
+static const size_t HEADER_BYTES = 24;
+static const size_t ENTRY_BYTES = 32;
+
+// splitmix64 finalizer.
+static uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static uint64_t combine(uint64_t h, uint64_t x) {
+    return mix(h ^ (x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+static uint64_t hashName(uint64_t tag, const string& name) {
+    uint64_t h = tag;
+    for (unsigned char c : name)
+        h = (h ^ c) * 0x100000001b3ULL;
+    return mix(h);
+}
+
+void netHashes(const Netlist& nl, const vector<int>& piIndex, const vector<string>& inputs,
+               vector<uint64_t>& hashes) {
+    hashes.assign(nl.numNets(), 0);
+    for (size_t n = 0; n < nl.numNets(); n++) {
+        if (piIndex[n] >= 0)
+            hashes[n] = hashName(1, inputs[piIndex[n]]);
+        else if ((int)n == nl.vdd)
+            hashes[n] = mix(3);
+        else if ((int)n == nl.vss)
+            hashes[n] = mix(4);
+        else
+            hashes[n] = hashName(2, nl.netNames[n]);
+    }
+    for (size_t g = 0; g < nl.numGates(); g++) {
+        int out = nl.gateOuts[g];
+        GateType type = nl.gateTypes[g];
+        if (type == GATE_DFF || type == GATE_UNKNOWN || piIndex[out] >= 0 || out == nl.vdd || out == nl.vss)
+            continue;
+        const CellDef& cell = nl.lib.cell(nl.gateCells[g]);
+        uint64_t h = combine(combine(mix(5), (uint64_t)type << 8 | cell.numInputs), cell.truth);
+        for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+            h = combine(h, hashes[nl.fanins[k]]);
+        hashes[out] = h;
+    }
+}
+
+//--------------------------------------------------------------------
+
+bool ProofCache::load(const string& path, ostream& err) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return true;
+    if (!file.open(path)) {
+        err << "-E- Could not read proof cache " << path << endl;
+        return false;
+    }
+    uint64_t n = 0, b = 0;
+    bool ok = file.size() >= HEADER_BYTES && !memcmp(file.data(), CACHE_MAGIC, 8);
+    if (ok) {
+        memcpy(&n, file.data() + 8, 8);
+        memcpy(&b, file.data() + 16, 8);
+        ok = n <= (file.size() - HEADER_BYTES) / ENTRY_BYTES &&
+             file.size() == HEADER_BYTES + n * ENTRY_BYTES + b;
+    }
+    if (!ok) {
+        err << "-E- " << path << " is not a proof cache" << endl;
+        file.close();
+        return false;
+    }
+    entries = file.data() + HEADER_BYTES;
+    numEntries = n;
+    bits = (const unsigned char*)entries + n * ENTRY_BYTES;
+    bitsBytes = b;
+    return true;
+}
+
+bool ProofCache::findMapped(const ProofKey& key, Entry& e) const {
+    size_t lo = 0, hi = numEntries;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        memcpy(&e, entries + mid * ENTRY_BYTES, ENTRY_BYTES);
+        ProofKey k = {e.spec, e.impl};
+        if (k < key)
+            lo = mid + 1;
+        else if (key < k)
+            hi = mid;
+        else
+            return e.bitOffset + e.numBits <= bitsBytes * 8;
+    }
+    return false;
+}
+
+bool ProofCache::lookup(const ProofKey& key, bool& proven, vector<bool>& cex) const {
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = added.find(key);
+        if (it != added.end()) {
+            proven = it->second.proven;
+            cex = it->second.cex;
+            return true;
+        }
+    }
+    Entry e;
+    if (!findMapped(key, e))
+        return false;
+    proven = e.proven != 0;
+    cex.resize(e.numBits);
+    for (uint32_t i = 0; i < e.numBits; i++) {
+        uint64_t bit = e.bitOffset + i;
+        cex[i] = (bits[bit / 8] >> (bit % 8)) & 1;
+    }
+    return true;
+}
+
+void ProofCache::store(const ProofKey& key, bool proven, const vector<bool>& cex) {
+    lock_guard<mutex> guard(lock);
+    Verdict& v = added[key];
+    v.proven = proven;
+    v.cex = proven ? vector<bool>() : cex;
+}
+
+bool ProofCache::save(const string& path, ostream& err) {
+    lock_guard<mutex> guard(lock);
+    // Merge the mapped entries (both lists are sorted; added ones win).
+    vector<Entry> out;
+    vector<unsigned char> outBits;
+    uint64_t numBits = 0;
+    auto addBits = [&](Entry& e, const vector<bool>& cex) {
+        e.numBits = cex.size();
+        e.bitOffset = numBits;
+        for (bool v : cex) {
+            if (numBits % 8 == 0)
+                outBits.push_back(0);
+            if (v)
+                outBits.back() |= 1 << (numBits % 8);
+            numBits++;
+        }
+    };
+    auto it = added.begin();
+    vector<bool> cex;
+    for (size_t i = 0; i <= numEntries; i++) {
+        Entry e;
+        ProofKey k = {~0ULL, ~0ULL};
+        if (i < numEntries) {
+            memcpy(&e, entries + i * ENTRY_BYTES, ENTRY_BYTES);
+            k = ProofKey{e.spec, e.impl};
+        }
+        for (; it != added.end() && (i == numEntries || !(k < it->first)); ++it) {
+            Entry a = {it->first.spec, it->first.impl, it->second.proven, 0, 0};
+            addBits(a, it->second.cex);
+            out.push_back(a);
+            if (i < numEntries && !(it->first < k))
+                e.proven = 2;           // replaced
+        }
+        if (i == numEntries || e.proven == 2 || e.bitOffset + e.numBits > bitsBytes * 8)
+            continue;
+        cex.resize(e.numBits);
+        for (uint32_t b = 0; b < e.numBits; b++) {
+            uint64_t bit = e.bitOffset + b;
+            cex[b] = (bits[bit / 8] >> (bit % 8)) & 1;
+        }
+        addBits(e, cex);
+        out.push_back(e);
+    }
+
+    string tmp = path + ".tmp";
+    ofstream f(tmp.c_str(), ios::binary);
+    uint64_t n = out.size(), b = outBits.size();
+    f.write(CACHE_MAGIC, 8);
+    f.write((const char*)&n, 8);
+    f.write((const char*)&b, 8);
+    for (const Entry& e : out)
+        f.write((const char*)&e, ENTRY_BYTES);
+    f.write((const char*)outBits.data(), outBits.size());
+    f.close();
+    if (!f || rename(tmp.c_str(), path.c_str()) != 0) {
+        err << "-E- Could not write proof cache " << path << endl;
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef FEV_PROOFCACHE_H
+#define FEV_PROOFCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include "netlist.h"
+#include "vlgread.h"
+
+//--------------------------------------------------------------------
+// Persistent proof cache (--cache). The verdict of an output pair is a
+// function of its two cones only, so it is stored under a structural
+// hash of the spec cone and one of the impl cone: proven, or failed
+// with its counterexample. A re-run after an ECO finds the unchanged
+// cones in the cache and only checks the others.
+//
+// File format (host byte order): the magic "FEVPRF1\n", the number of
+// entries and the size of the bit area (8 bytes each), the entries
+// sorted by key (32 bytes each) and the bit area holding the
+// counterexamples. The file is mapped and searched in place, so loading
+// costs nothing per entry; new entries are merged in on save.
+
+// Structural hash of every net: primary inputs by name, VDD/VSS as
+// constants, other free nets (undriven, flop outputs) by name, and gate
+// outputs from the cell function and the hashes of the fanins in pin
+// order. Equal hashes mean equal cones up to net and instance names.
+// piIndex is the primary input position of a net (-1 for others); the
+// netlist must be acyclic.
+void netHashes(const Netlist& nl, const std::vector<int>& piIndex, const std::vector<std::string>& inputs,
+               std::vector<uint64_t>& hashes);
+
+struct ProofKey {
+    uint64_t spec, impl;        // hashes of the two output nets
+
+    bool operator<(const ProofKey& o) const { return spec != o.spec ? spec < o.spec : impl < o.impl; }
+};
+
+class ProofCache {
+public:
+    ProofCache() : entries(NULL), numEntries(0), bits(NULL), bitsBytes(0) {}
+
+    // Map a cache file. A missing file is an empty cache; a file that is
+    // not a cache is reported on 'err' and gives false.
+    bool load(const std::string& path, std::ostream& err);
+    // Write the mapped and the added entries to 'path' (through a
+    // temporary file, so an interrupted save keeps the old cache).
+    bool save(const std::string& path, std::ostream& err);
+
+    // Verdict of a cone pair, false if it is not in the cache. A failed
+    // pair comes with its counterexample (the values its owner stored).
+    bool lookup(const ProofKey& key, bool& proven, std::vector<bool>& cex) const;
+    void store(const ProofKey& key, bool proven, const std::vector<bool>& cex);
+
+    size_t numLoaded() const { return numEntries; }
+    size_t numAdded() const { return added.size(); }
+
+private:
+    struct Entry {
+        uint64_t spec, impl;
+        uint32_t proven, numBits;
+        uint64_t bitOffset;
+    };
+    struct Verdict {
+        bool proven;
+        std::vector<bool> cex;
+    };
+
+    bool findMapped(const ProofKey& key, Entry& e) const;
+
+    MappedFile file;
+    const char* entries;
+    size_t numEntries;
+    const unsigned char* bits;
+    size_t bitsBytes;
+    std::map<ProofKey, Verdict> added;
+    mutable std::mutex lock;        // added is shared by the pairs of -b
+};
+
+#endif
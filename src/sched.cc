@@ -0,0 +1,63 @@
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "sched.h"
+
+using namespace std;
+
+namespace {
+
+struct WorkerQueue {
+    mutex lock;
+    deque<size_t> jobs;
+};
+
+}
+
+size_t runWorkStealing(const vector<size_t>& order, int numThreads, const function<void(size_t)>& run) {
+    if (numThreads < 1)
+        numThreads = 1;
+    vector<WorkerQueue> queues(numThreads);
+    for (size_t i = 0; i < order.size(); i++)
+        queues[i % numThreads].jobs.push_back(order[i]);
+    atomic<size_t> steals(0);
+
+    auto worker = [&](int self) {
+        for (;;) {
+            size_t job = 0;
+            bool found = false;
+            {
+                lock_guard<mutex> guard(queues[self].lock);
+                if (!queues[self].jobs.empty()) {
+                    job = queues[self].jobs.front();
+                    queues[self].jobs.pop_front();
+                    found = true;
+                }
+            }
+            // Jobs never create jobs, so once every queue is empty the
+            // worker is done.
+            for (int k = 1; k < numThreads && !found; k++) {
+                WorkerQueue& victim = queues[(self + k) % numThreads];
+                lock_guard<mutex> guard(victim.lock);
+                if (!victim.jobs.empty()) {
+                    job = victim.jobs.back();
+                    victim.jobs.pop_back();
+                    found = true;
+                    steals++;
+                }
+            }
+            if (!found)
+                return;
+            run(job);
+        }
+    };
+
+    vector<thread> threads;
+    for (int t = 1; t < numThreads; t++)
+        threads.push_back(thread(worker, t));
+    worker(0);
+    for (auto& t : threads)
+        t.join();
+    return steals;
+}
@@ -0,0 +1,18 @@
+#ifndef FEV_SCHED_H
+#define FEV_SCHED_H
+
+#include <stddef.h>
+#include <vector>
+#include <functional>
+
+//--------------------------------------------------------------------
+// Work-stealing job pool. The jobs in 'order' are dealt round-robin to
+// numThreads workers; each worker runs its own jobs front to back (so
+// the first jobs in 'order' start first) and, when it runs dry, steals
+// from the back of another worker's queue. run(job) is called exactly
+// once per job, from some worker thread. Returns the number of jobs
+// that were stolen.
+size_t runWorkStealing(const std::vector<size_t>& order, int numThreads,
+                       const std::function<void(size_t)>& run);
+
+#endif
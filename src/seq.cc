@@ -0,0 +1,187 @@
+#include <map>
+#include <unordered_map>
+#include "seq.h"
+#include "sim.h"
+
+using namespace std;
+
+// Cycles of the random input sequences that give the flop signatures.
+static const int SIGNATURE_CYCLES = 16;
+
+string gateName(const Netlist& nl, int gate) {
+    hcmInstance* inst = nl.gateInsts[gate];
+    return inst ? inst->getName() : nl.netNames[nl.gateOuts[gate]];
+}
+
+// D net of a plain flop, -1 for other gates.
+static int dataNet(const Netlist& nl, int gate) {
+    if (nl.gateTypes[gate] != GATE_DFF)
+        return -1;
+    int pin = nl.lib.cell(nl.gateCells[gate]).dataPin;
+    return pin < 0 ? -1 : nl.fanins[nl.gateFaninBegin(gate) + pin];
+}
+
+// Signature of every plain flop of both netlists: a hash of its values
+// over SIGNATURE_CYCLES cycles of shared random inputs, starting from
+// the all-zero state. Flops that are not plain stay free (random).
+static void registerSignatures(const Netlist& spec, const Netlist& imp, const vector<string>& primaryInputs,
+                               const vector<int>& specFlops, const vector<int>& impFlops,
+                               vector<uint64_t>& specSigs, vector<uint64_t>& impSigs) {
+    const Netlist* nls[2] = {&spec, &imp};
+    const vector<int>* flops[2] = {&specFlops, &impFlops};
+    vector<uint64_t>* sigs[2] = {&specSigs, &impSigs};
+    Simulator spSim(spec), imSim(imp);
+    Simulator* sims[2] = {&spSim, &imSim};
+    vector<uint64_t> state[2];
+    vector<int> ins[2];
+    for (int s = 0; s < 2; s++) {
+        state[s].assign(flops[s]->size() * SIM_WORDS, 0);
+        sigs[s]->assign(flops[s]->size(), 0);
+        for (const auto& in : primaryInputs)
+            ins[s].push_back(nls[s]->findNet(in));
+    }
+    SimRandom rnd(1);
+    for (int cycle = 0; cycle < SIGNATURE_CYCLES; cycle++) {
+        for (int s = 0; s < 2; s++)
+            randomizeFreeNets(*nls[s], *sims[s], rnd);
+        for (size_t i = 0; i < primaryInputs.size(); i++) {
+            for (int w = 0; w < SIM_WORDS; w++) {
+                uint64_t word = rnd.next();
+                for (int s = 0; s < 2; s++)
+                    if (ins[s][i] >= 0)
+                        sims[s]->value(ins[s][i])[w] = word;
+            }
+        }
+        for (int s = 0; s < 2; s++) {
+            const Netlist& nl = *nls[s];
+            Simulator& sim = *sims[s];
+            for (size_t f = 0; f < flops[s]->size(); f++) {
+                uint64_t* q = sim.value(nl.gateOuts[(*flops[s])[f]]);
+                uint64_t& sig = (*sigs[s])[f];
+                for (int w = 0; w < SIM_WORDS; w++) {
+                    q[w] = state[s][f * SIM_WORDS + w];
+                    sig = (sig ^ q[w]) * 0x100000001b3ULL + cycle;
+                }
+            }
+            sim.run();
+            for (size_t f = 0; f < flops[s]->size(); f++) {
+                const uint64_t* d = sim.value(dataNet(nl, (*flops[s])[f]));
+                for (int w = 0; w < SIM_WORDS; w++)
+                    state[s][f * SIM_WORDS + w] = d[w];
+            }
+        }
+    }
+}
+
+void matchRegisters(const Netlist& spec, const Netlist& imp, const vector<string>& primaryInputs,
+                    RegisterMatch& match) {
+    vector<int> specFlops, impFlops;
+    for (size_t g = 0; g < spec.numGates(); g++)
+        if (spec.gateTypes[g] == GATE_DFF)
+            (dataNet(spec, g) >= 0 ? specFlops : match.specUnmatched).push_back(g);
+    for (size_t g = 0; g < imp.numGates(); g++)
+        if (imp.gateTypes[g] == GATE_DFF)
+            (dataNet(imp, g) >= 0 ? impFlops : match.impUnmatched).push_back(g);
+
+    // By instance name, then by Q net name.
+    vector<char> specPaired(specFlops.size(), 0), impPaired(impFlops.size(), 0);
+    for (int byNet = 0; byNet < 2; byNet++) {
+        unordered_map<string, size_t> specByName;
+        for (size_t f = 0; f < specFlops.size(); f++) {
+            int g = specFlops[f];
+            if (!specPaired[f])
+                specByName[byNet ? spec.netNames[spec.gateOuts[g]] : gateName(spec, g)] = f;
+        }
+        for (size_t f = 0; f < impFlops.size(); f++) {
+            int g = impFlops[f];
+            if (impPaired[f])
+                continue;
+            auto it = specByName.find(byNet ? imp.netNames[imp.gateOuts[g]] : gateName(imp, g));
+            if (it == specByName.end() || specPaired[it->second])
+                continue;
+            specPaired[it->second] = impPaired[f] = 1;
+            match.pairs.push_back(RegisterPair{specFlops[it->second], g, gateName(spec, specFlops[it->second]),
+                                               false});
+        }
+    }
+
+    // The rest by signature, where it is unique on both sides.
+    vector<uint64_t> specSigs, impSigs;
+    registerSignatures(spec, imp, primaryInputs, specFlops, impFlops, specSigs, impSigs);
+    map<uint64_t, pair<int, int>> specCount, impCount;     // signature -> (count, flop)
+    for (size_t f = 0; f < specFlops.size(); f++)
+        if (!specPaired[f]) {
+            auto& c = specCount[specSigs[f]];
+            c.first++;
+            c.second = f;
+        }
+    for (size_t f = 0; f < impFlops.size(); f++)
+        if (!impPaired[f]) {
+            auto& c = impCount[impSigs[f]];
+            c.first++;
+            c.second = f;
+        }
+    for (const auto& sc : specCount) {
+        auto ic = impCount.find(sc.first);
+        if (sc.second.first != 1 || ic == impCount.end() || ic->second.first != 1)
+            continue;
+        size_t s = sc.second.second, i = ic->second.second;
+        specPaired[s] = impPaired[i] = 1;
+        match.pairs.push_back(RegisterPair{specFlops[s], impFlops[i], gateName(spec, specFlops[s]), true});
+    }
+
+    for (size_t f = 0; f < specFlops.size(); f++)
+        if (!specPaired[f])
+            match.specUnmatched.push_back(specFlops[f]);
+    for (size_t f = 0; f < impFlops.size(); f++)
+        if (!impPaired[f])
+            match.impUnmatched.push_back(impFlops[f]);
+}
+
+void exposeRegisters(Netlist& nl, const vector<int>& flops, const vector<string>& names) {
+    int buf = nl.lib.derivedCell(GATE_BUF, 1, gateTruth(GATE_BUF, 1));
+    vector<int> flopIndex(nl.numGates(), -1);
+    for (size_t k = 0; k < flops.size(); k++)
+        flopIndex[flops[k]] = k;
+
+    vector<int> cells, outs, faninStart(1, 0), fanins;
+    vector<GateType> types;
+    vector<hcmInstance*> insts;
+    auto addGate = [&](int cell, GateType type, int out, const int* ins, int numIns, hcmInstance* inst) {
+        cells.push_back(cell);
+        types.push_back(type);
+        outs.push_back(out);
+        fanins.insert(fanins.end(), ins, ins + numIns);
+        faninStart.push_back(fanins.size());
+        insts.push_back(inst);
+    };
+    // Flops become buffers from their Q inputs, in place (flops come
+    // first, so the order stays topological); the D buffers go last.
+    vector<int> dNets(flops.size());
+    for (size_t g = 0; g < nl.numGates(); g++) {
+        int k = flopIndex[g];
+        if (k < 0) {
+            addGate(nl.gateCells[g], nl.gateTypes[g], nl.gateOuts[g], &nl.fanins[0] + nl.gateFaninBegin(g),
+                    nl.gateFaninEnd(g) - nl.gateFaninBegin(g), nl.gateInsts[g]);
+            continue;
+        }
+        dNets[k] = dataNet(nl, g);
+        int q = nl.netId("Q:" + names[k]);
+        nl.inputs.push_back(q);
+        addGate(buf, GATE_BUF, nl.gateOuts[g], &q, 1, nl.gateInsts[g]);
+    }
+    for (size_t k = 0; k < flops.size(); k++) {
+        int d = nl.netId("D:" + names[k]);
+        nl.outputs.push_back(d);
+        addGate(buf, GATE_BUF, d, &dNets[k], 1, nl.gateInsts[flops[k]]);
+    }
+    nl.gateCells.swap(cells);
+    nl.gateTypes.swap(types);
+    nl.gateOuts.swap(outs);
+    nl.faninStart.swap(faninStart);
+    nl.fanins.swap(fanins);
+    nl.gateInsts.swap(insts);
+    nl.driver.assign(nl.numNets(), -1);
+    for (size_t g = 0; g < nl.numGates(); g++)
+        nl.driver[nl.gateOuts[g]] = g;
+}
@@ -0,0 +1,44 @@
+#ifndef FEV_SEQ_H
+#define FEV_SEQ_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "netlist.h"
+
+//--------------------------------------------------------------------
+// Register correspondence (-S). The flops of the two designs are paired
+// by name and, for the rest, by a sequential simulation signature. A
+// pair's Q nets become one shared pseudo primary input and its D nets a
+// pseudo primary output pair, so the sequential check reduces to the
+// combinational check of the outputs and the next-state functions.
+// This proves equivalence from corresponding initial states; flops left
+// unmatched stay free in each design and can cause false differences.
+
+struct RegisterPair {
+    int specGate, impGate;      // the flops
+    std::string name;           // spec instance name
+    bool bySignature;
+};
+
+struct RegisterMatch {
+    std::vector<RegisterPair> pairs;
+    std::vector<int> specUnmatched, impUnmatched;   // flop gates
+};
+
+// Instance name of a gate (the net it drives if it has no instance).
+std::string gateName(const Netlist& nl, int gate);
+
+// Pair the plain flops (see CellDef::dataPin) of the two netlists: first
+// by instance name, then by the name of the Q net, then by equal values
+// over a few cycles of random input sequences from the all-zero state
+// (signatures that occur once on each side). Other flops are unmatched.
+void matchRegisters(const Netlist& spec, const Netlist& imp, const std::vector<std::string>& primaryInputs,
+                    RegisterMatch& match);
+
+// Expose the given flops of a netlist: flop k is replaced by a buffer
+// from the new primary input "Q:<names[k]>" to its Q net, and its D net
+// drives the new primary output "D:<names[k]>" through a buffer.
+void exposeRegisters(Netlist& nl, const std::vector<int>& flops, const std::vector<std::string>& names);
+
+#endif
@@ -0,0 +1,208 @@
+#include "sim.h"
+
+using namespace std;
+
+// Build the word kernels for the wider vector units too and pick one at
+// load time.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(__clang__)
+#define SIM_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SIM_KERNEL
+#endif
+
+SIM_KERNEL
+static void simGate(GateType type, uint64_t* out, const uint64_t* vals, const int* in, const int* inEnd) {
+    uint64_t acc[SIM_WORDS];
+    const uint64_t* first = &vals[(size_t)in[0] * SIM_WORDS];
+    for (int w = 0; w < SIM_WORDS; w++)
+        acc[w] = first[w];
+    for (const int* i = in + 1; i < inEnd; i++) {
+        const uint64_t* v = &vals[(size_t)*i * SIM_WORDS];
+        switch (type) {
+        case GATE_AND:
+        case GATE_NAND:
+            for (int w = 0; w < SIM_WORDS; w++)
+                acc[w] &= v[w];
+            break;
+        case GATE_OR:
+        case GATE_NOR:
+            for (int w = 0; w < SIM_WORDS; w++)
+                acc[w] |= v[w];
+            break;
+        case GATE_XOR:
+        case GATE_XNOR:
+            for (int w = 0; w < SIM_WORDS; w++)
+                acc[w] ^= v[w];
+            break;
+        default:
+            break;
+        }
+    }
+    bool invert = type == GATE_INV || type == GATE_NAND || type == GATE_NOR || type == GATE_XNOR;
+    for (int w = 0; w < SIM_WORDS; w++)
+        out[w] = invert ? ~acc[w] : acc[w];
+}
+
+// Cells without a dedicated kernel: the sum of the on-set primes.
+SIM_KERNEL
+static void simTable(const CellDef& cell, uint64_t* out, const uint64_t* vals, const int* in) {
+    uint64_t res[SIM_WORDS] = {0};
+    for (const CellCube& c : cell.onCubes) {
+        uint64_t acc[SIM_WORDS];
+        for (int w = 0; w < SIM_WORDS; w++)
+            acc[w] = ~0ULL;
+        for (int i = 0; i < cell.numInputs; i++) {
+            if (!(c.care >> i & 1))
+                continue;
+            const uint64_t* v = &vals[(size_t)in[i] * SIM_WORDS];
+            uint64_t flip = c.value >> i & 1 ? 0 : ~0ULL;
+            for (int w = 0; w < SIM_WORDS; w++)
+                acc[w] &= v[w] ^ flip;
+        }
+        for (int w = 0; w < SIM_WORDS; w++)
+            res[w] |= acc[w];
+    }
+    for (int w = 0; w < SIM_WORDS; w++)
+        out[w] = res[w];
+}
+
+Simulator::Simulator(const Netlist& nl) : nl(nl), vals(nl.numNets() * SIM_WORDS, 0) {}
+
+void Simulator::run() {
+    if (nl.vdd >= 0)
+        for (int w = 0; w < SIM_WORDS; w++)
+            value(nl.vdd)[w] = ~0ULL;
+    if (nl.vss >= 0)
+        for (int w = 0; w < SIM_WORDS; w++)
+            value(nl.vss)[w] = 0;
+    for (size_t g = 0; g < nl.numGates(); g++) {
+        GateType type = nl.gateTypes[g];
+        if (type == GATE_DFF || type == GATE_UNKNOWN)
+            continue;
+        if (type == GATE_TABLE) {
+            simTable(nl.lib.cell(nl.gateCells[g]), value(nl.gateOuts[g]), vals.data(),
+                     &nl.fanins[nl.gateFaninBegin(g)]);
+            continue;
+        }
+        simGate(type, value(nl.gateOuts[g]), vals.data(),
+                &nl.fanins[nl.gateFaninBegin(g)], &nl.fanins[0] + nl.gateFaninEnd(g));
+    }
+}
+
+uint64_t SimRandom::next() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void randomizeFreeNets(const Netlist& nl, Simulator& sim, SimRandom& rnd) {
+    for (size_t g = 0; g < nl.numGates(); g++)
+        if (nl.gateTypes[g] == GATE_DFF || nl.gateTypes[g] == GATE_UNKNOWN)
+            for (int w = 0; w < SIM_WORDS; w++)
+                sim.value(nl.gateOuts[g])[w] = rnd.next();
+    for (size_t n = 0; n < nl.numNets(); n++)
+        if (nl.driver[n] < 0)
+            for (int w = 0; w < SIM_WORDS; w++)
+                sim.value(n)[w] = rnd.next();
+}
+
+size_t randomSimulate(const Netlist& spec, const Netlist& imp,
+                      const vector<string>& primaryInputs, const vector<string>& outputs,
+                      int rounds, uint64_t seed, bool stopAtFirst, vector<SimMismatch>& mismatches) {
+    Simulator specSim(spec), impSim(imp);
+    SimRandom rnd(seed);
+    vector<int> specIns, impIns, specOuts, impOuts;
+    for (const auto& in : primaryInputs) {
+        specIns.push_back(spec.findNet(in));
+        impIns.push_back(imp.findNet(in));
+    }
+    for (const auto& out : outputs) {
+        specOuts.push_back(spec.findNet(out));
+        impOuts.push_back(imp.findNet(out));
+    }
+
+    vector<bool> failed(outputs.size(), false);
+    size_t numFailed = 0;
+    vector<uint64_t> piWords(primaryInputs.size() * SIM_WORDS);
+    for (int round = 0; round < rounds && numFailed < outputs.size(); round++) {
+        randomizeFreeNets(spec, specSim, rnd);
+        randomizeFreeNets(imp, impSim, rnd);
+        for (size_t i = 0; i < primaryInputs.size(); i++) {
+            for (int w = 0; w < SIM_WORDS; w++) {
+                uint64_t word = rnd.next();
+                piWords[i * SIM_WORDS + w] = word;
+                if (specIns[i] >= 0)
+                    specSim.value(specIns[i])[w] = word;
+                if (impIns[i] >= 0)
+                    impSim.value(impIns[i])[w] = word;
+            }
+        }
+        specSim.run();
+        impSim.run();
+
+        // Each newly failing output is reported with the first pattern
+        // that exposes it; outputs sharing that pattern share the mismatch.
+        size_t firstNew = mismatches.size();
+        vector<int> patternOf;   // pattern bit of mismatches[firstNew + k]
+        for (size_t o = 0; o < outputs.size(); o++) {
+            if (failed[o])
+                continue;
+            const uint64_t* s = specSim.value(specOuts[o]);
+            const uint64_t* t = impSim.value(impOuts[o]);
+            int bit = -1;
+            for (int w = 0; w < SIM_WORDS && bit < 0; w++)
+                if (s[w] != t[w])
+                    bit = w * 64 + __builtin_ctzll(s[w] ^ t[w]);
+            if (bit < 0)
+                continue;
+            failed[o] = true;
+            numFailed++;
+            size_t k = 0;
+            while (k < patternOf.size() && patternOf[k] != bit)
+                k++;
+            if (k == patternOf.size()) {
+                patternOf.push_back(bit);
+                SimMismatch m;
+                for (size_t i = 0; i < primaryInputs.size(); i++)
+                    m.inputValues.push_back((piWords[i * SIM_WORDS + bit / 64] >> (bit % 64)) & 1);
+                mismatches.push_back(m);
+            }
+            mismatches[firstNew + k].outputs.push_back(o);
+        }
+        if (stopAtFirst && numFailed)
+            break;
+    }
+    return numFailed;
+}
+
+void replayCounterExamples(const Netlist& spec, const Netlist& imp, const vector<string>& primaryInputs,
+                           const vector<string>& outputs, uint64_t seed, vector<SimReplay>& replays) {
+    Simulator specSim(spec), impSim(imp);
+    SimRandom rnd(seed);
+    vector<int> specIns, impIns;
+    for (const auto& in : primaryInputs) {
+        specIns.push_back(spec.findNet(in));
+        impIns.push_back(imp.findNet(in));
+    }
+    for (SimReplay& r : replays) {
+        randomizeFreeNets(spec, specSim, rnd);
+        randomizeFreeNets(imp, impSim, rnd);
+        for (size_t i = 0; i < primaryInputs.size(); i++) {
+            for (int w = 0; w < SIM_WORDS; w++) {
+                uint64_t word = r.inputValues[i] < 0 ? rnd.next() : (r.inputValues[i] ? ~0ULL : 0);
+                if (specIns[i] >= 0)
+                    specSim.value(specIns[i])[w] = word;
+                if (impIns[i] >= 0)
+                    impSim.value(impIns[i])[w] = word;
+            }
+        }
+        specSim.run();
+        impSim.run();
+        const uint64_t* s = specSim.value(spec.findNet(outputs[r.output]));
+        const uint64_t* t = impSim.value(imp.findNet(outputs[r.output]));
+        r.exposed = 0;
+        for (int w = 0; w < SIM_WORDS; w++)
+            r.exposed += __builtin_popcountll(s[w] ^ t[w]);
+    }
+}
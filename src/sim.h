@@ -0,0 +1,82 @@
+#ifndef FEV_SIM_H
+#define FEV_SIM_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "netlist.h"
+
+//--------------------------------------------------------------------
+// Bit-parallel simulation. Every net holds SIM_WORDS machine words, so
+// one levelized pass over the netlist evaluates 64 * SIM_WORDS input
+// patterns. The per-gate word loops have a fixed trip count and are
+// compiled for AVX2/AVX-512 where the CPU has them.
+const int SIM_WORDS = 4;
+const int SIM_PATTERNS = 64 * SIM_WORDS;
+
+class Simulator {
+public:
+    Simulator(const Netlist& nl);
+
+    // Net values: SIM_WORDS words per net.
+    uint64_t* value(int net) { return &vals[(size_t)net * SIM_WORDS]; }
+    const uint64_t* value(int net) const { return &vals[(size_t)net * SIM_WORDS]; }
+    // Evaluate all gates in topological order. Flop and unsupported gate
+    // outputs keep the values they were given (they are free nets).
+    void run();
+
+private:
+    const Netlist& nl;
+    std::vector<uint64_t> vals;
+};
+
+// Deterministic pseudo-random words (splitmix64).
+class SimRandom {
+public:
+    SimRandom(uint64_t seed) : state(seed) {}
+    uint64_t next();
+private:
+    uint64_t state;
+};
+
+// Give every free net (undriven, flop or unsupported gate output) fresh
+// random words. Primary inputs are undriven too, so set them afterwards.
+void randomizeFreeNets(const Netlist& nl, Simulator& sim, SimRandom& rnd);
+
+// A failing pattern found by random simulation.
+struct SimMismatch {
+    std::vector<bool> inputValues;    // per primary input (in the order given)
+    std::vector<size_t> outputs;      // indices of the output pairs it exposes
+};
+
+// Run 'rounds' passes of random patterns through both netlists, with the
+// primary inputs shared by name, and compare the output pairs. Free nets
+// (undriven, flop or unsupported gate outputs) get independent random
+// values, like the free variables they become in the CNF. Every output
+// pair that differs is reported once, in the mismatch of the first
+// pattern that exposed it. With stopAtFirst the run ends at the first
+// pass that has a mismatch. Returns the number of failing outputs.
+size_t randomSimulate(const Netlist& spec, const Netlist& imp,
+                      const std::vector<std::string>& primaryInputs,
+                      const std::vector<std::string>& outputs,
+                      int rounds, uint64_t seed, bool stopAtFirst,
+                      std::vector<SimMismatch>& mismatches);
+
+// A counterexample to replay: a value per primary input (0, 1, or -1
+// for an input it leaves open) and the output pair it should expose.
+struct SimReplay {
+    std::vector<signed char> inputValues;
+    size_t output;
+    int exposed = 0;        // patterns (of SIM_PATTERNS) in which the pair differed
+};
+
+// Replay counterexamples through both netlists, one pass each: the
+// inputs a counterexample sets hold their values in every pattern, the
+// open inputs and the free nets get random ones. A counterexample that
+// forces its difference exposes it in all SIM_PATTERNS patterns.
+void replayCounterExamples(const Netlist& spec, const Netlist& imp,
+                           const std::vector<std::string>& primaryInputs,
+                           const std::vector<std::string>& outputs, uint64_t seed,
+                           std::vector<SimReplay>& replays);
+
+#endif
@@ -0,0 +1,364 @@
+#include <algorithm>
+#include "simplify.h"
+
+using namespace std;
+
+CnfSize netlistCnfSize(const Netlist& nl) {
+    CnfSize size{nl.numGates(), 0, 0};
+    vector<char> used(nl.numNets(), 0);
+    for (size_t g = 0; g < nl.numGates(); g++) {
+        const CellDef& cell = nl.lib.cell(nl.gateCells[g]);
+        if (cell.type == GATE_DFF || cell.type == GATE_UNKNOWN)
+            continue;
+        used[nl.gateOuts[g]] = 1;
+        for (int k = nl.gateFaninBegin(g); k < nl.gateFaninEnd(g); k++)
+            used[nl.fanins[k]] = 1;
+        size.vars += cell.numAuxVars;
+        size.clauses += cell.numClauses;
+    }
+    for (size_t n = 0; n < nl.numNets(); n++)
+        size.vars += used[n];
+    // VDD/VSS are forced by a unit clause each.
+    if (nl.vdd >= 0 && used[nl.vdd])
+        size.clauses++;
+    if (nl.vss >= 0 && used[nl.vss])
+        size.clauses++;
+    return size;
+}
+
+namespace {
+
+// Value of a net during simplification: 2 * net + complement, where the
+// net carries the value in the new netlist, or a constant.
+const int LIT_FALSE = -2, LIT_TRUE = -1;
+
+int litNot(int l) {
+    return l < 0 ? (l == LIT_FALSE ? LIT_TRUE : LIT_FALSE) : l ^ 1;
+}
+
+uint64_t tableMask(int n) {
+    return n == 6 ? ~0ULL : (1ULL << (1 << n)) - 1;
+}
+
+class Simplifier {
+public:
+    Simplifier(const Netlist& in, Netlist& out, SimplifyStats& stats)
+        : in(in), out(out), stats(stats), lits(in.numNets()), carried(in.numNets(), 0) {}
+
+    void run();
+
+private:
+    void addGate(int cell, int outNet, const int* fanins, int n, hcmInstance* inst);
+    int carrier(int net, bool own);
+    void reduceTruth(int g, uint64_t truth, const vector<int>& ins);
+    void reduceWide(int g);
+    void removeDead();
+
+    const Netlist& in;
+    Netlist& out;
+    SimplifyStats& stats;
+    vector<int> lits;        // net -> current value
+    vector<char> carried;    // net got a driver that produces its value
+    vector<int> vars, ins;   // scratch space
+};
+
+void Simplifier::addGate(int cell, int outNet, const int* fanins, int n, hcmInstance* inst) {
+    out.gateCells.push_back(cell);
+    out.gateTypes.push_back(out.lib.cell(cell).type);
+    out.gateOuts.push_back(outNet);
+    out.gateInsts.push_back(inst);
+    out.fanins.insert(out.fanins.end(), fanins, fanins + n);
+    out.faninStart.push_back(out.fanins.size());
+}
+
+// A net that carries the value of 'net' in the new netlist. A positive
+// alias is its source net; otherwise (or if the net itself must carry
+// it, as primary outputs do) a buffer, inverter or tie cell is added to
+// drive 'net'.
+int Simplifier::carrier(int net, bool own) {
+    int l = lits[net];
+    if (l == 2 * net || carried[net])
+        return net;
+    if ((net == in.vdd && l == LIT_TRUE) || (net == in.vss && l == LIT_FALSE))
+        return net;
+    if (!own && l >= 0 && !(l & 1))
+        return l >> 1;
+    if (!own && l == LIT_TRUE && in.vdd >= 0)
+        return in.vdd;
+    if (!own && l == LIT_FALSE && in.vss >= 0)
+        return in.vss;
+    if (l < 0) {
+        addGate(out.lib.derivedCell(GATE_TABLE, 0, l == LIT_TRUE), net, NULL, 0, NULL);
+    } else {
+        int src = l >> 1;
+        bool inv = l & 1;
+        addGate(out.lib.derivedCell(inv ? GATE_INV : GATE_BUF, 1, inv ? 1 : 2), net, &src, 1, NULL);
+    }
+    carried[net] = 1;
+    return net;
+}
+
+// Gate g computes 'truth' over the values 'ins' (in pin order). Fold the
+// constants and polarities into the table, merge repeated nets, drop the
+// nets it does not depend on, and emit what is left: a constant, an
+// alias, or a gate over the remaining nets.
+void Simplifier::reduceTruth(int g, uint64_t truth, const vector<int>& ins) {
+    int n = ins.size();
+    vars.clear();
+    vector<int> varOf(n, -1);
+    for (int i = 0; i < n; i++) {
+        if (ins[i] < 0)
+            continue;
+        int x = ins[i] >> 1;
+        auto it = find(vars.begin(), vars.end(), x);
+        varOf[i] = it - vars.begin();
+        if (it == vars.end())
+            vars.push_back(x);
+    }
+    int k = vars.size();
+    uint64_t t = 0;
+    for (unsigned m = 0; m < (1u << k); m++) {
+        unsigned idx = 0;
+        for (int i = 0; i < n; i++) {
+            bool bit = ins[i] < 0 ? ins[i] == LIT_TRUE : ((m >> varOf[i]) & 1) ^ (ins[i] & 1);
+            idx |= (unsigned)bit << i;
+        }
+        if (truth >> idx & 1)
+            t |= 1ULL << m;
+    }
+    // Drop the variables outside the support.
+    for (int j = k - 1; j >= 0; j--) {
+        bool depends = false;
+        for (unsigned m = 0; m < (1u << k) && !depends; m++)
+            if (!(m >> j & 1) && (t >> m & 1) != (t >> (m | 1u << j) & 1))
+                depends = true;
+        if (depends)
+            continue;
+        uint64_t r = 0;
+        for (unsigned m = 0; m < (1u << (k - 1)); m++) {
+            unsigned low = m & ((1u << j) - 1);
+            unsigned full = ((m >> j) << (j + 1)) | low;
+            if (t >> full & 1)
+                r |= 1ULL << m;
+        }
+        t = r;
+        vars.erase(vars.begin() + j);
+        k--;
+    }
+
+    int outNet = in.gateOuts[g];
+    if (k == 0) {
+        lits[outNet] = t & 1 ? LIT_TRUE : LIT_FALSE;
+        stats.constGates++;
+        return;
+    }
+    if (k == 1 && (t == 1 || t == 2)) {
+        lits[outNet] = 2 * vars[0] + (t == 1);
+        stats.aliasGates++;
+        return;
+    }
+    int cell = in.gateCells[g];
+    bool same = k == in.gateFaninEnd(g) - in.gateFaninBegin(g) && t == in.lib.cell(cell).truth &&
+                equal(vars.begin(), vars.end(), in.fanins.begin() + in.gateFaninBegin(g));
+    if (!same) {
+        cell = out.lib.derivedCell(GATE_TABLE, k, t);
+        stats.rewritten++;
+    }
+    addGate(cell, outNet, vars.data(), k, in.gateInsts[g]);
+    lits[outNet] = 2 * outNet;
+}
+
+// Gates of the and/or/xor families that are too wide for a truth table.
+void Simplifier::reduceWide(int g) {
+    GateType type = in.gateTypes[g];
+    int outNet = in.gateOuts[g];
+    vector<pair<int, int>> terms;     // (value, fanin net)
+    for (int k = in.gateFaninBegin(g); k < in.gateFaninEnd(g); k++)
+        terms.push_back(make_pair(lits[in.fanins[k]], in.fanins[k]));
+
+    if (type == GATE_XOR || type == GATE_XNOR) {
+        // Constants and complements only flip the output.
+        bool inv = type == GATE_XNOR;
+        vector<int> xs;
+        for (auto& t : terms) {
+            inv ^= t.first < 0 ? t.first == LIT_TRUE : t.first & 1;
+            if (t.first >= 0)
+                xs.push_back(t.first & ~1);
+        }
+        // x ^ x = 0
+        sort(xs.begin(), xs.end());
+        ins.clear();
+        for (size_t i = 0; i < xs.size(); i++) {
+            if (i + 1 < xs.size() && xs[i] == xs[i + 1])
+                i++;
+            else
+                ins.push_back(xs[i]);
+        }
+        int r = ins.size();
+        if (r <= CELL_MAX_TABLE_INPUTS) {
+            reduceTruth(g, gateTruth(GATE_XOR, r) ^ (inv ? tableMask(r) : 0), ins);
+            return;
+        }
+        vars.clear();
+        for (int x : ins)
+            vars.push_back(x >> 1);
+        int cell = out.lib.derivedCell(inv ? GATE_XNOR : GATE_XOR, r, 0);
+        stats.rewritten += r != (int)terms.size() || inv != (type == GATE_XNOR);
+        addGate(cell, outNet, vars.data(), r, in.gateInsts[g]);
+        lits[outNet] = 2 * outNet;
+        return;
+    }
+
+    // OR(x, ...) = ~AND(~x, ...): work on an AND of literals.
+    bool orType = type == GATE_OR || type == GATE_NOR;
+    bool inv = type == GATE_NAND || type == GATE_OR;
+    vector<pair<int, int>> kept;
+    for (auto& t : terms) {
+        int l = orType ? litNot(t.first) : t.first;
+        if (l == LIT_FALSE) {
+            lits[outNet] = inv ? LIT_TRUE : LIT_FALSE;
+            stats.constGates++;
+            return;
+        }
+        if (l != LIT_TRUE)
+            kept.push_back(make_pair(l, t.second));
+    }
+    sort(kept.begin(), kept.end());
+    vector<pair<int, int>> uniq;
+    for (auto& t : kept) {
+        if (!uniq.empty() && uniq.back().first == t.first)
+            continue;
+        if (!uniq.empty() && uniq.back().first == (t.first ^ 1)) {
+            // x & ~x = 0
+            lits[outNet] = inv ? LIT_TRUE : LIT_FALSE;
+            stats.constGates++;
+            return;
+        }
+        uniq.push_back(t);
+    }
+    int r = uniq.size();
+    if (r <= CELL_MAX_TABLE_INPUTS) {
+        ins.clear();
+        for (auto& t : uniq)
+            ins.push_back(t.first);
+        reduceTruth(g, gateTruth(inv ? GATE_NAND : GATE_AND, r), ins);
+        return;
+    }
+    // All complemented: a NOR (or OR) of the sources. Mixed: keep the
+    // complemented fanins as nets of their own.
+    bool allNeg = true;
+    for (auto& t : uniq)
+        allNeg = allNeg && (t.first & 1);
+    vars.clear();
+    for (auto& t : uniq)
+        vars.push_back(allNeg || !(t.first & 1) ? t.first >> 1 : carrier(t.second, false));
+    GateType newType = allNeg ? (inv ? GATE_OR : GATE_NOR) : (inv ? GATE_NAND : GATE_AND);
+    stats.rewritten += newType != type || r != (int)terms.size();
+    addGate(out.lib.derivedCell(newType, r, 0), outNet, vars.data(), r, in.gateInsts[g]);
+    lits[outNet] = 2 * outNet;
+}
+
+// Keep only the gates in the transitive fan-in of the primary outputs
+// (through flops) and set up the driver table.
+void Simplifier::removeDead() {
+    vector<int> driver(out.numNets(), -1);
+    for (size_t g = 0; g < out.numGates(); g++)
+        driver[out.gateOuts[g]] = g;
+    vector<char> live(out.numGates(), 0);
+    vector<int> stack;
+    for (int po : out.outputs)
+        if (driver[po] >= 0 && !live[driver[po]]) {
+            live[driver[po]] = 1;
+            stack.push_back(driver[po]);
+        }
+    while (!stack.empty()) {
+        int g = stack.back();
+        stack.pop_back();
+        for (int k = out.gateFaninBegin(g); k < out.gateFaninEnd(g); k++) {
+            int d = driver[out.fanins[k]];
+            if (d >= 0 && !live[d]) {
+                live[d] = 1;
+                stack.push_back(d);
+            }
+        }
+    }
+
+    vector<int> cells, outs, start(1, 0), fanins;
+    vector<GateType> types;
+    vector<hcmInstance*> insts;
+    for (size_t g = 0; g < out.numGates(); g++) {
+        if (!live[g]) {
+            stats.dead++;
+            continue;
+        }
+        out.driver[out.gateOuts[g]] = cells.size();
+        cells.push_back(out.gateCells[g]);
+        types.push_back(out.gateTypes[g]);
+        outs.push_back(out.gateOuts[g]);
+        insts.push_back(out.gateInsts[g]);
+        fanins.insert(fanins.end(), out.fanins.begin() + out.gateFaninBegin(g),
+                      out.fanins.begin() + out.gateFaninEnd(g));
+        start.push_back(fanins.size());
+    }
+    out.gateCells.swap(cells);
+    out.gateTypes.swap(types);
+    out.gateOuts.swap(outs);
+    out.gateInsts.swap(insts);
+    out.faninStart.swap(start);
+    out.fanins.swap(fanins);
+}
+
+void Simplifier::run() {
+    for (const auto& name : in.netNames)
+        out.netId(name);
+    out.inputs = in.inputs;
+    out.outputs = in.outputs;
+    out.vdd = in.vdd;
+    out.vss = in.vss;
+    out.lib = in.lib;
+    out.faninStart.assign(1, 0);
+    for (size_t n = 0; n < in.numNets(); n++)
+        lits[n] = 2 * n;
+    if (in.vdd >= 0)
+        lits[in.vdd] = LIT_TRUE;
+    if (in.vss >= 0)
+        lits[in.vss] = LIT_FALSE;
+
+    // Flop (and unsupported cell) outputs stay free nets. Their fanins are
+    // connected once all values are known.
+    vector<int> sources;
+    for (size_t g = 0; g < in.numGates(); g++) {
+        GateType type = in.gateTypes[g];
+        if (type != GATE_DFF && type != GATE_UNKNOWN)
+            continue;
+        sources.push_back(g);
+        addGate(in.gateCells[g], in.gateOuts[g], &in.fanins[0] + in.gateFaninBegin(g),
+                in.gateFaninEnd(g) - in.gateFaninBegin(g), in.gateInsts[g]);
+    }
+    for (size_t g = 0; g < in.numGates(); g++) {
+        GateType type = in.gateTypes[g];
+        if (type == GATE_DFF || type == GATE_UNKNOWN)
+            continue;
+        const CellDef& cell = in.lib.cell(in.gateCells[g]);
+        if (cell.numInputs > CELL_MAX_TABLE_INPUTS) {
+            reduceWide(g);
+            continue;
+        }
+        ins.clear();
+        for (int k = in.gateFaninBegin(g); k < in.gateFaninEnd(g); k++)
+            ins.push_back(lits[in.fanins[k]]);
+        reduceTruth(g, cell.truth, ins);
+    }
+    for (size_t s = 0; s < sources.size(); s++)
+        for (int k = out.gateFaninBegin(s); k < out.gateFaninEnd(s); k++)
+            out.fanins[k] = carrier(out.fanins[k], false);
+    for (int po : out.outputs)
+        carrier(po, true);
+    removeDead();
+}
+
+}
+
+void simplifyNetlist(const Netlist& in, Netlist& out, SimplifyStats& stats) {
+    Simplifier(in, out, stats).run();
+}
@@ -0,0 +1,30 @@
+#ifndef FEV_SIMPLIFY_H
+#define FEV_SIMPLIFY_H
+
+#include "netlist.h"
+
+//--------------------------------------------------------------------
+// Netlist simplification before encoding. Constants (VDD/VSS and tie
+// cells) are folded through the gates, buffer and inverter chains
+// become aliases of their source net whose polarity the reading gates
+// absorb into their cell, and logic that reaches no primary output is
+// deleted. Net ids and names are kept and every primary output keeps a
+// driver, so the result can stand in for the original netlist.
+
+// Size of the CNF of a whole netlist, as the encoder would emit it.
+struct CnfSize {
+    size_t gates, vars, clauses;
+};
+
+CnfSize netlistCnfSize(const Netlist& nl);
+
+struct SimplifyStats {
+    size_t constGates = 0;   // gates folded to a constant
+    size_t aliasGates = 0;   // gates reduced to a (possibly inverted) fanin
+    size_t rewritten = 0;    // gates whose cell changed
+    size_t dead = 0;         // gates that reach no output
+};
+
+void simplifyNetlist(const Netlist& in, Netlist& out, SimplifyStats& stats);
+
+#endif
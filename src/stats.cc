@@ -0,0 +1,125 @@
+#include <time.h>
+#include <sys/resource.h>
+#include <stdio.h>
+#include <chrono>
+#include <iomanip>
+#include "stats.h"
+
+using namespace std;
+
+double wallClock() {
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double clockSeconds(clockid_t id) {
+    struct timespec ts;
+    if (clock_gettime(id, &ts) != 0)
+        return 0;
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double processCpuClock() { return clockSeconds(CLOCK_PROCESS_CPUTIME_ID); }
+
+double threadCpuClock() { return clockSeconds(CLOCK_THREAD_CPUTIME_ID); }
+
+long peakRssKb() {
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0)
+        return 0;
+    return ru.ru_maxrss;     // kilobytes on Linux
+}
+
+void RunStats::addPhase(const string& name, double wall, double cpu) {
+    for (auto& p : phases) {
+        if (p.name == name) {
+            p.wall += wall;
+            p.cpu += cpu;
+            return;
+        }
+    }
+    phases.push_back(Phase{name, wall, cpu});
+}
+
+void RunStats::addPhases(const RunStats& o) {
+    for (const auto& p : o.phases)
+        addPhase(p.name, p.wall, p.cpu);
+}
+
+void RunStats::addDesign(const string& name, size_t gates, size_t vars, size_t clauses) {
+    designs.push_back(Design{name, gates, vars, clauses, -1});
+}
+
+void RunStats::setEncodedGates(const string& name, long gates) {
+    for (auto& d : designs)
+        if (d.name == name)
+            d.encodedGates = gates;
+}
+
+void RunStats::addOutput(const string& name, const char* status, const OutputStats& st) {
+    outputs.push_back(Output{name, status, st});
+}
+
+// A JSON string literal.
+static string jsonString(const string& s) {
+    string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            r += '\\';
+            r += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            r += buf;
+        } else {
+            r += c;
+        }
+    }
+    return r + "\"";
+}
+
+static void writeCounts(ostream& out, const SolverCounts& c) {
+    out << "\"conflicts\": " << c.conflicts << ", \"decisions\": " << c.decisions
+        << ", \"propagations\": " << c.propagations;
+}
+
+void RunStats::writeJson(ostream& out, const string& verdict, const CheckStats& check) const {
+    ios::fmtflags flags = out.flags();
+    out << fixed << setprecision(6);
+    out << "{" << endl;
+    if (!spec.empty())
+        out << "  \"spec\": " << jsonString(spec) << ", \"impl\": " << jsonString(impl) << "," << endl;
+    out << "  \"verdict\": " << jsonString(verdict) << "," << endl;
+    out << "  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++)
+        out << (i ? "," : "") << endl << "    {\"name\": " << jsonString(phases[i].name)
+            << ", \"wall_s\": " << phases[i].wall << ", \"cpu_s\": " << phases[i].cpu << "}";
+    out << endl << "  ]," << endl;
+    out << "  \"designs\": [";
+    for (size_t i = 0; i < designs.size(); i++) {
+        const Design& d = designs[i];
+        out << (i ? "," : "") << endl << "    {\"name\": " << jsonString(d.name) << ", \"gates\": " << d.gates
+            << ", \"vars\": " << d.vars << ", \"clauses\": " << d.clauses;
+        if (d.encodedGates >= 0)
+            out << ", \"encoded_gates\": " << d.encodedGates;
+        out << "}";
+    }
+    out << endl << "  ]," << endl;
+    out << "  \"solver\": {\"vars\": " << check.vars << ", \"clauses\": " << check.clauses << ", ";
+    writeCounts(out, check.counts);
+    if (check.elimRuns)
+        out << ", \"eliminated_vars\": " << check.elimVars << ", \"clauses_before_elim\": "
+            << check.elimClausesBefore << ", \"clauses_after_elim\": " << check.elimClausesAfter;
+    out << "}," << endl;
+    out << "  \"outputs\": [";
+    for (size_t i = 0; i < outputs.size(); i++) {
+        const Output& o = outputs[i];
+        out << (i ? "," : "") << endl << "    {\"name\": " << jsonString(o.name) << ", \"status\": "
+            << jsonString(o.status) << ", \"engine\": " << jsonString(o.st.engine) << ", \"queries\": " << o.st.queries << ", ";
+        writeCounts(out, o.st.counts);
+        out << ", \"solve_s\": " << o.st.solveSeconds << "}";
+    }
+    out << endl << "  ]," << endl;
+    out << "  \"peak_rss_kb\": " << peakRssKb() << endl;
+    out << "}" << endl;
+    out.flags(flags);
+}
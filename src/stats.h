@@ -0,0 +1,131 @@
+#ifndef FEV_STATS_H
+#define FEV_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+//--------------------------------------------------------------------
+// Run statistics for --stats: wall and CPU time per phase, design and
+// CNF sizes, solver work per output and peak memory, written as JSON.
+
+// Seconds since an arbitrary start (monotonic).
+double wallClock();
+// CPU seconds of the whole process (all threads).
+double processCpuClock();
+// CPU seconds of the calling thread.
+double threadCpuClock();
+// Peak resident set size of the process, in kilobytes.
+long peakRssKb();
+
+// Solver work counters (MiniSat's conflicts/decisions/propagations).
+struct SolverCounts {
+    uint64_t conflicts = 0, decisions = 0, propagations = 0;
+
+    void add(const SolverCounts& o) {
+        conflicts += o.conflicts;
+        decisions += o.decisions;
+        propagations += o.propagations;
+    }
+};
+
+// Solver work of the queries an output took part in; a query on a group
+// of outputs counts for each of them.
+struct OutputStats {
+    unsigned queries = 0;
+    SolverCounts counts;
+    double solveSeconds = 0;
+    const char* engine = "";    // what decided it: sim, cache, strash, keypoint, bdd or sat
+};
+
+// CNF generation and solving effort of one check. With several solvers
+// (-j) the times are summed over the jobs.
+struct CheckStats {
+    double encodeWall = 0, encodeCpu = 0;
+    double solveWall = 0, solveCpu = 0;
+    size_t vars = 0, clauses = 0;       // solver size at the end
+    SolverCounts counts;
+    // Variable elimination (-e): solvers preprocessed, variables
+    // eliminated, and the clauses before and after.
+    size_t elimRuns = 0, elimVars = 0, elimClausesBefore = 0, elimClausesAfter = 0;
+    double elimWall = 0, elimCpu = 0;
+
+    void add(const CheckStats& o) {
+        encodeWall += o.encodeWall;
+        encodeCpu += o.encodeCpu;
+        solveWall += o.solveWall;
+        solveCpu += o.solveCpu;
+        vars += o.vars;
+        clauses += o.clauses;
+        counts.add(o.counts);
+        elimRuns += o.elimRuns;
+        elimVars += o.elimVars;
+        elimClausesBefore += o.elimClausesBefore;
+        elimClausesAfter += o.elimClausesAfter;
+        elimWall += o.elimWall;
+        elimCpu += o.elimCpu;
+    }
+};
+
+class RunStats {
+public:
+    // Top cells of the checked pair.
+    void setPair(const std::string& specTop, const std::string& implTop) {
+        spec = specTop;
+        impl = implTop;
+    }
+
+    // Add time to a phase; phases are listed in order of first use.
+    void addPhase(const std::string& name, double wall, double cpu);
+    // Add all phase times of 'o' (e.g. collected on another thread).
+    void addPhases(const RunStats& o);
+
+    // Gate, variable and clause counts of a design's full CNF, and how
+    // many of its gates went into the solver (-1 if not known).
+    void addDesign(const std::string& name, size_t gates, size_t vars, size_t clauses);
+    void setEncodedGates(const std::string& name, long gates);
+
+    // One entry per output, with its final status.
+    void addOutput(const std::string& name, const char* status, const OutputStats& st);
+
+    void writeJson(std::ostream& out, const std::string& verdict, const CheckStats& check) const;
+
+private:
+    struct Phase {
+        std::string name;
+        double wall, cpu;
+    };
+    struct Design {
+        std::string name;
+        size_t gates, vars, clauses;
+        long encodedGates;
+    };
+    struct Output {
+        std::string name;
+        const char* status;
+        OutputStats st;
+    };
+    std::string spec, impl;
+    std::vector<Phase> phases;
+    std::vector<Design> designs;
+    std::vector<Output> outputs;
+};
+
+// Adds the wall and CPU time of its lifetime to a phase. CPU time is
+// that of the calling thread, so pairs checked side by side (-b) do not
+// count each other's work.
+class ScopedPhase {
+public:
+    ScopedPhase(RunStats& stats, const char* name)
+        : stats(stats), name(name), wall(wallClock()), cpu(threadCpuClock()) {}
+    ~ScopedPhase() { stats.addPhase(name, wallClock() - wall, threadCpuClock() - cpu); }
+
+private:
+    RunStats& stats;
+    const char* name;
+    double wall, cpu;
+};
+
+#endif
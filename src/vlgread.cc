@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vlgread.h"
+
+using namespace std;
+
+bool MappedFile::open(const string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            base = (char*)p;
+            len = st.st_size;
+            mapped = true;
+            ::close(fd);
+            return true;
+        }
+    }
+    // Not mappable: read it.
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        copy.insert(copy.end(), buf, buf + n);
+    ::close(fd);
+    if (n < 0) {
+        copy.clear();
+        return false;
+    }
+    base = copy.data();
+    len = copy.size();
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped)
+        munmap(base, len);
+    base = NULL;
+    len = 0;
+    mapped = false;
+    copy.clear();
+}
+
+//--------------------------------------------------------------------
+
+// Position of 'pat' in [p, end), 'end' if it does not occur.
+static const char* findText(const char* p, const char* end, const char* pat) {
+    return search(p, end, pat, pat + strlen(pat));
+}
+
+bool scanVerilog(const string& path, VerilogScan& scan) {
+    scan = VerilogScan();
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    scan.readable = true;
+    scan.bytes = file.size();
+    const char* p = file.data();
+    const char* end = p + file.size();
+    scan.lines = count(p, end, '\n');
+
+    bool expectName = false;
+    while (p < end) {
+        if (*p == '/' && p + 1 < end && p[1] == '/') {
+            p = find(p, end, '\n');
+            continue;
+        }
+        if (*p == '/' && p + 1 < end && p[1] == '*') {
+            p = findText(p + 2, end, "*/");
+            p = p == end ? end : p + 2;
+            continue;
+        }
+        if (!isalpha((unsigned char)*p) && *p != '_' && *p != '\\') {
+            p++;
+            continue;
+        }
+        const char* w = p;
+        while (p < end && !isspace((unsigned char)*p) && !strchr("(;,#", *p))
+            p++;
+        if (expectName)
+            scan.modules.push_back(string(w, p));
+        expectName = p - w == 6 && !memcmp(w, "module", 6);
+    }
+    return true;
+}
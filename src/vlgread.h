@@ -0,0 +1,47 @@
+#ifndef FEV_VLGREAD_H
+#define FEV_VLGREAD_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------
+// Memory-mapped file reading. hcm can only parse Verilog from a path,
+// so the maps serve the readers of our own: the module scan of the batch
+// design pool (-b) and the proof cache (--cache).
+
+// Read-only map of a whole file. Files that cannot be mapped (pipes,
+// empty files) are read into memory instead.
+class MappedFile {
+public:
+    MappedFile() : base(NULL), len(0), mapped(false) {}
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return base; }
+    size_t size() const { return len; }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    char* base;
+    size_t len;
+    bool mapped;
+    std::vector<char> copy;
+};
+
+// What a scan of a Verilog file found.
+struct VerilogScan {
+    bool readable = false;
+    size_t bytes = 0, lines = 0;
+    std::vector<std::string> modules;   // defined modules, in file order
+};
+
+// Tokenize one file (comments skipped) and collect its module names.
+// Returns false if the file cannot be read.
+bool scanVerilog(const std::string& path, VerilogScan& scan);
+
+#endif
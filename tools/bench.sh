@@ -0,0 +1,67 @@
+#!/bin/sh
+# Benchmark harness: generates the benchgen pairs at growing widths, runs
+# the checker on each pair and records the verdict, wall time, solve time
+# and peak memory.
+#
+# usage: bench.sh checker benchgen out-dir "checker flags" width...
+# env:   BENCH_TIMEOUT  seconds per run (default 60)
+#        BENCH_SEED     seed of the ECO mutations (default 1)
+#
+# The results go to out-dir/bench.csv and are printed as a table. The
+# exit status is 1 if an equivalent pair was reported not equivalent (or
+# the other way around for a pair known to differ).
+
+if [ $# -lt 5 ]; then
+    echo "usage: $0 checker benchgen out-dir \"checker flags\" width..." >&2
+    exit 2
+fi
+fev=$1
+gen=$2
+dir=$3
+flags=$4
+shift 4
+timeout_s=${BENCH_TIMEOUT:-60}
+seed=${BENCH_SEED:-1}
+
+mkdir -p "$dir" || exit 2
+csv="$dir/bench.csv"
+echo "pair,width,flags,expected,verdict,wall_s,solve_s,peak_rss_kb" > "$csv"
+printf "%-22s %5s %-15s %8s %8s %10s\n" pair width verdict wall_s solve_s peak_rss_kb
+status=0
+
+# run name width specTop specFile implTop implFile expected
+run() {
+    json="$dir/$1_$2.json"
+    rm -f "$json"
+    start=$(date +%s.%N)
+    timeout "$timeout_s" "$fev" $flags "--stats=json:$json" -s "$3" "$dir/stdcell.v" "$dir/$4" \
+        -i "$5" "$dir/stdcell.v" "$dir/$6" > "$dir/$1_$2.log" 2>&1
+    rc=$?
+    wall=$(echo "$start $(date +%s.%N)" | awk '{ printf "%.3f", $2 - $1 }')
+    verdict=$(sed -n 's/.*"verdict": "\([a-z_]*\)".*/\1/p' "$json" 2>/dev/null)
+    solve=$(sed -n 's/.*"name": "solve", "wall_s": \([0-9.]*\).*/\1/p' "$json" 2>/dev/null)
+    rss=$(sed -n 's/.*"peak_rss_kb": \([0-9]*\).*/\1/p' "$json" 2>/dev/null)
+    if [ $rc = 124 ]; then
+        verdict=timeout
+    elif [ -z "$verdict" ]; then
+        verdict=error
+    fi
+    if [ "$7" != any ] && { [ "$verdict" = equivalent ] || [ "$verdict" = not_equivalent ]; } \
+        && [ "$verdict" != "$7" ]; then
+        verdict="$verdict!"
+        status=1
+    fi
+    printf "%-22s %5s %-15s %8s %8s %10s\n" "$1" "$2" "$verdict" "$wall" "${solve:--}" "${rss:--}"
+    echo "$1,$2,$flags,$7,$verdict,$wall,$solve,$rss" >> "$csv"
+}
+
+for n in "$@"; do
+    "$gen" "$dir" "$n" "$seed" || exit 2
+    run add_rca_vs_cla "$n" AddRca$n add_rca_$n.v AddCla$n add_cla_$n.v equivalent
+    run add_rca_vs_eco "$n" AddRca$n add_rca_$n.v AddEco$n add_eco_$n.v any
+    run par_chain_vs_tree "$n" ParChain$n par_chain_$n.v ParTree$n par_tree_$n.v equivalent
+    run mul_array_vs_booth "$n" MulArray$n mul_array_$n.v MulBooth$n mul_booth_$n.v equivalent
+    run mul_array_vs_eco "$n" MulArray$n mul_array_$n.v MulEco$n mul_eco_$n.v any
+done
+echo "results in $csv"
+exit $status